@@ -4,13 +4,16 @@
 
 static char buffer[BUFFER_SIZE]; // Define a static buffer to hold the data
 static ssize_t buffer_pointer = 0;
+static DEFINE_MUTEX(buffer_lock); // Serialises readers and writers of the buffer
+
+struct tera_stats tera_stats;
 
 /*
 This function is called when the device file is opened
 */
 int driver_open(struct inode *device_file, struct file *instance)
 {
-    printk("dev_nr - open was called!\n");
+    trace_tera_open(device_file->i_rdev);
     return 0;
 }
 
@@ -20,48 +23,75 @@ This function is called when the device file is closed
 
 int driver_close(struct inode *device_file, struct file *instance)
 {
-    printk("dev_nr - close was called!\n");
+    trace_tera_close(device_file->i_rdev);
     return 0;
 }
 
-ssize_t driver_write(struct file *File, const char *user_buffer, size_t count, loff_t *offs)
+ssize_t driver_write(struct kiocb *iocb, struct iov_iter *from)
 {
-    int to_copy, not_copied, delta;
+    u64 start = tera_stats_start(), ns;
+    size_t count = iov_iter_count(from);
+    int to_copy, not_copied, delta, space_available;
 
-    /* Get amount of data to copy */
-    int space_available = BUFFER_SIZE - buffer_pointer;
+    mutex_lock(&buffer_lock);
+
+    /* Get the free space of the buffer */
+    space_available = BUFFER_SIZE - buffer_pointer;
 
     /* Get amount of data to copy */
-    to_copy = min(count, space_available);
+    to_copy = min_t(size_t, count, space_available);
 
     /* Copy data to buffer */
-    not_copied = copy_from_user(buffer + buffer_pointer, user_buffer, to_copy);
+    not_copied = to_copy - copy_from_iter(buffer + buffer_pointer, to_copy, from);
     buffer_pointer += to_copy - not_copied;
+    mutex_unlock(&buffer_lock);
+
     /* Calculate data */
     delta = to_copy - not_copied;
 
+    /* Bytes that did not fit in the buffer are lost for this write */
+    tera_stats_add(&tera_stats, TERA_PATH_WRITE, TERA_STAT_DROPS, count - to_copy);
+    if (to_copy < count)
+    {
+        tera_pmu_add(TERA_PMU_BUFFER_FULL, 1);
+    }
+    tera_pmu_add(TERA_PMU_BYTES_WRITTEN, delta);
+    ns = tera_stats_op(&tera_stats, TERA_PATH_WRITE, delta, count, start);
+
+    /* A static branch while disabled. ns is not extra work, the latency histogram needs it anyway */
+    trace_tera_write(file_inode(iocb->ki_filp)->i_rdev, count, delta, ns);
     return delta;
 }
 
-ssize_t driver_read(struct file *File, char *user_buffer, size_t count, loff_t *offs) {
+ssize_t driver_read(struct kiocb *iocb, struct iov_iter *to) {
+    u64 start = tera_stats_start(), ns;
+    size_t count = iov_iter_count(to);
     int to_copy, not_copied, delta;
 
+    mutex_lock(&buffer_lock);
+
     /* Get amount of data to copy */
-    to_copy = min(count, buffer_pointer);
+    to_copy = min_t(size_t, count, buffer_pointer);
 
     if (to_copy == 0) {
         // No data to read, return EOF
+        mutex_unlock(&buffer_lock);
+        ns = tera_stats_op(&tera_stats, TERA_PATH_READ, 0, count, start);
+        trace_tera_read(file_inode(iocb->ki_filp)->i_rdev, count, 0, ns);
         return 0;
     }
 
     /* Copy data to user */
-    not_copied = copy_to_user(user_buffer, buffer, to_copy);
+    not_copied = to_copy - copy_to_iter(buffer, to_copy, to);
 
     /* Adjust buffer pointer */
     buffer_pointer -= to_copy - not_copied;
+    mutex_unlock(&buffer_lock);
 
     /* Calculate data */
     delta = to_copy - not_copied;
 
+    ns = tera_stats_op(&tera_stats, TERA_PATH_READ, delta, count, start);
+    trace_tera_read(file_inode(iocb->ki_filp)->i_rdev, count, delta, ns);
     return delta;
 }
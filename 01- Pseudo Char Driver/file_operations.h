@@ -6,12 +6,22 @@
 #include <linux/cdev.h>
 #include <linux/uaccess.h>
 #include <linux/device.h>
+#include <linux/uio.h>
+#include "../common/tera_stats.h"
+#include "../common/tera_trace.h"
+#include "../common/tera_pmu.h"
 
+/* Counters and latency histograms of the device, see debugfs tera/tera/teraDriver */
+extern struct tera_stats tera_stats;
 
 int driver_open(struct inode *device_file, struct file *instance);
 int driver_close(struct inode *device_file, struct file *instance);
-ssize_t driver_write(struct file *File, const char *user_buffer, size_t count, loff_t *offs);
-ssize_t driver_read(struct file *File,char *user_buffer, size_t count, loff_t *offs);
+/*
+ * read/write take an iov_iter, so kernel_read()/kernel_write() work on the
+ * device as well as the read()/write() system calls.
+ */
+ssize_t driver_write(struct kiocb *iocb, struct iov_iter *from);
+ssize_t driver_read(struct kiocb *iocb, struct iov_iter *to);
 
 
 
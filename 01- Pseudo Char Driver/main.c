@@ -19,13 +19,23 @@ struct mydata
         .owner = THIS_MODULE,
         .open = driver_open,
         .release = driver_close,
-        .read = driver_read,
-        .write = driver_write}};
+        .read_iter = driver_read,
+        .write_iter = driver_write}};
+
+/* debugfs directory of the module, /sys/kernel/debug/tera/tera */
+static struct dentry *tera_debugfs;
 
 static int __init teraINIT(void)
 {
     printk("HELLO from tera\n");
 
+    /* Per-CPU counters and latency histograms of driver_read/driver_write */
+    if (tera_stats_init(&tera_stats))
+    {
+        printk("Statistics can not be allocated!\n");
+        return -ENOMEM;
+    }
+
 /**
  * ========== alloc_chrdev_region() =============
  * Allocates a range of character device numbers dynamically.
@@ -39,6 +49,7 @@ static int __init teraINIT(void)
     if (alloc_chrdev_region(&teraData_st.my_device_nr, 0, 1, DRIVER_NAME) < 0)
     {
         printk("Device Nr. could not be allocated!\n");
+        tera_stats_exit(&tera_stats);
         return -1;
     }
     printk("%s retval=0 - registered Device number Major: %d, Minor: %d\n", __FUNCTION__, MAJOR(teraData_st.my_device_nr), MINOR(teraData_st.my_device_nr));
@@ -101,6 +112,9 @@ static int __init teraINIT(void)
         printk("Can not create device file!\n");
         goto FileError;
     }
+
+    tera_debugfs = tera_stats_module_dir(KBUILD_MODNAME);
+    tera_stats_debugfs(&tera_stats, tera_debugfs, DRIVER_NAME);
     return 0;
 FileError:
     class_destroy(teraData_st.my_class);
@@ -108,15 +122,18 @@ ClassError:
     cdev_del(&teraData_st.cdev_object);
 DEV_ERROR:
     unregister_chrdev_region(teraData_st.my_device_nr, 1);
+    tera_stats_exit(&tera_stats);
     return -1;
 }
 
 static void __exit teraDEINIT(void)
 {
+    debugfs_remove(tera_debugfs);
     device_destroy(teraData_st.my_class,teraData_st.my_device_nr);
     class_destroy(teraData_st.my_class);
     cdev_del(&teraData_st.cdev_object);
     unregister_chrdev_region(teraData_st.my_device_nr, 1);
+    tera_stats_exit(&tera_stats);
     printk("Goodbye from tera \n");
 }
 /* Macro: module_init
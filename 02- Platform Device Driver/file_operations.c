@@ -3,25 +3,73 @@
  * Date: 29/4/2024
  */
 
+#include <linux/mutex.h>
+#include <linux/slab.h>
 #include "file_operations.h"
+#include "gpio_queue.h"
+#include "gpio_flush.h"
+#include "gpio_rt.h"
 
-static char RED_1[3] = {0};
-static char RED_2[3] = {0};
-static char GREEN[3] = {0};
+/*
+ * TERA_WRITE_CHUNK: Bytes copied from user space per step of a write.
+ */
+#define TERA_WRITE_CHUNK 64
 
-int global_minor;
+struct tera_led __rcu *tera_leds[TERA_GPIO_MAX_PINS];
 
 /*
- * Enum: devices
- * -------------
- * Enumerates the devices.
+ * Function: tera_led_free
+ * -----------------------
+ * RCU callback freeing a LED once no mask walk can see it any more.
  */
-enum devices
+static void tera_led_free(struct rcu_head *rcu)
 {
-    RED_1_e = 2,
-    RED_2_e,
-    GREEN_e
-} status;
+    struct tera_led *led = container_of(rcu, struct tera_led, rcu);
+
+    tera_stats_exit(&led->stats);
+    kfree(led);
+}
+
+/*
+ * Function: tera_led_release
+ * --------------------------
+ * kref release of a LED.
+ */
+static void tera_led_release(struct kref *ref)
+{
+    call_rcu(&container_of(ref, struct tera_led, ref)->rcu, tera_led_free);
+}
+
+void tera_led_put(struct tera_led *led)
+{
+    kref_put(&led->ref, tera_led_release);
+}
+
+struct gpio_desc *tera_gpio_desc(int pin)
+{
+    struct gpio_desc *desc = NULL;
+    struct tera_led *led;
+
+    rcu_read_lock();
+    led = rcu_dereference(tera_leds[pin]);
+    if (led)
+    {
+        desc = led->desc;
+    }
+    rcu_read_unlock();
+    return desc;
+}
+
+/*
+ * Struct: tera_file
+ * -----------------
+ * State of one opened device file.
+ */
+struct tera_file
+{
+    struct tera_led *led; /* The opened LED, the file holds a reference */
+    u32 mode;             /* TERA_GPIO_MODE_TEXT or TERA_GPIO_MODE_BINARY */
+};
 
 /*
  * Function: driver_open
@@ -37,27 +85,49 @@ enum devices
  */
 int driver_open(struct inode *device_file, struct file *instance)
 {
-    /*
-     * Extract the major and minor numbers from the device identifier.
-     */
-    dev_t dev_id = device_file->i_rdev;
-    int major = MAJOR(dev_id);
-    int minor = MINOR(dev_id);
+    struct tera_led *led = NULL;
+    struct tera_file *tf;
 
     /*
-     * Store the minor number in a global variable.
+     * Extract the minor number from the device identifier.
      */
-    global_minor = minor;
+    int minor = MINOR(device_file->i_rdev);
 
     /*
-     * Associate the global minor number with the file instance.
+     * Take a reference to the LED, it stays valid until close even when
+     * the device is unbound meanwhile.
      */
-    instance->private_data = &global_minor;
+    rcu_read_lock();
+    if (minor < TERA_GPIO_MAX_PINS)
+    {
+        led = rcu_dereference(tera_leds[minor]);
+        if (led && !kref_get_unless_zero(&led->ref))
+        {
+            led = NULL;
+        }
+    }
+    rcu_read_unlock();
+
+    if (led == NULL)
+    {
+        return -ENODEV; // The LED of this minor is not probed
+    }
 
     /*
-     * Print a message indicating the device file is opened.
+     * Give every opened file its own state, so the LED and the write
+     * protocol of one file do not leak into another.
      */
-    printk("Opened device with major number %d and minor number %d\n", major, minor);
+    tf = kzalloc(sizeof(*tf), GFP_KERNEL);
+    if (tf == NULL)
+    {
+        tera_led_put(led);
+        return -ENOMEM;
+    }
+    tf->led = led;
+    tf->mode = TERA_GPIO_MODE_TEXT;
+    instance->private_data = tf;
+
+    trace_tera_open(device_file->i_rdev);
 
     return 0;
 }
@@ -70,81 +140,207 @@ int driver_open(struct inode *device_file, struct file *instance)
  */
 int driver_close(struct inode *device_file, struct file *instance)
 {
-    printk("close FUNCTION was called!\n");
+    struct tera_file *tf = instance->private_data;
 
+    trace_tera_close(device_file->i_rdev);
+
+    tera_led_put(tf->led);
+    kfree(tf);
     return 0;
 }
 
+/*
+ * Function: driver_write_text
+ * ---------------------------
+ * Text protocol: every '0' or '1' in the buffer clears or sets the LED,
+ * white space between commands is skipped.
+ *
+ * Returns:
+ * - Number of bytes consumed, or a negative error code when the buffer
+ *   starts with an invalid command.
+ */
+static ssize_t driver_write_text(struct tera_file *tf, struct iov_iter *from)
+{
+    size_t count = iov_iter_count(from);
+    char chunk[TERA_WRITE_CHUNK];
+    size_t done = 0;
+
+    while (done < count)
+    {
+        size_t to_copy = min_t(size_t, count - done, sizeof(chunk));
+        size_t i;
+
+        /*
+         * Copy data from the caller, user space or kernel, to the chunk.
+         */
+        if (copy_from_iter(chunk, to_copy, from) != to_copy)
+        {
+            return done ? done : -EFAULT;
+        }
+
+        /*
+         * Process the data and perform corresponding actions.
+         */
+        for (i = 0; i < to_copy; i++, done++)
+        {
+            switch (chunk[i])
+            {
+            case '0':
+                tera_gpio_write(tf->led->pin, 0);
+                break;
+            case '1':
+                tera_gpio_write(tf->led->pin, 1);
+                break;
+            case ' ':
+            case '\t':
+            case '\n':
+            case '\r':
+                break;
+            default:
+                return done ? done : -EINVAL;
+            }
+        }
+    }
+    return done;
+}
+
+/*
+ * Function: driver_write_binary
+ * -----------------------------
+ * Binary protocol: the buffer is an array of struct tera_gpio_op applied in
+ * order, so one write can carry thousands of pin updates.
+ *
+ * Returns:
+ * - Number of bytes of the valid leading ops, or a negative error code when
+ *   the length is not a whole number of ops or the first op is invalid.
+ */
+static ssize_t driver_write_binary(struct tera_file *tf, struct iov_iter *from)
+{
+    struct tera_gpio_op ops[TERA_WRITE_CHUNK / sizeof(struct tera_gpio_op)];
+    size_t count = iov_iter_count(from);
+    size_t done = 0;
+
+    if (count % sizeof(struct tera_gpio_op))
+    {
+        return -EINVAL;
+    }
+
+    while (done < count)
+    {
+        size_t to_copy = min_t(size_t, count - done, sizeof(ops));
+        size_t i, n = to_copy / sizeof(struct tera_gpio_op);
+
+        if (copy_from_iter(ops, to_copy, from) != to_copy)
+        {
+            return done ? done : -EFAULT;
+        }
+
+        for (i = 0; i < n; i++, done += sizeof(struct tera_gpio_op))
+        {
+            if (tera_gpio_apply_op(&ops[i]))
+            {
+                return done ? done : -EINVAL;
+            }
+        }
+    }
+    return done;
+}
+
 /*
  * Function: driver_write
  * ----------------------
  * Called when data is written to a device file.
  * 
  * Parameters:
- * - File: Pointer to the file structure representing the device file.
- * - user_buffer: Pointer to the buffer containing the data to be written.
- * - count: Number of bytes to write.
- * - offs: Pointer to the current file position.
+ * - iocb: The write request, iocb->ki_filp is the device file.
+ * - from: The data to be written, from user space or from the kernel.
  * 
  * Returns:
  * - Number of bytes successfully written, or a negative error code on failure.
  */
-ssize_t driver_write(struct file *File, const char *user_buffer, size_t count, loff_t *offs)
+ssize_t driver_write(struct kiocb *iocb, struct iov_iter *from)
 {
-    printk("Write function is entered\n");
-    char (*value)[3] = NULL;
-    int not_copied;
-    
-    /*
-     * Determine the device based on the minor number associated with the file.
-     */
-    if (*(int *)File->private_data == 0)
+    struct file *File = iocb->ki_filp;
+    struct tera_file *tf = File->private_data;
+    size_t count = iov_iter_count(from);
+    u64 start = tera_stats_start(), ns;
+    ssize_t ret;
+
+    if (tf->mode == TERA_GPIO_MODE_BINARY)
     {
-        printk("The minor who called write is minor 0\n");
-        value = &RED_1;
-        status = RED_1_e;
+        ret = driver_write_binary(tf, from);
     }
-    else if (*(int *)File->private_data == 1)
+    else
     {
-        printk("The minor who called write is minor 1\n");
-        value = &RED_2;
-        status = RED_2_e;
+        ret = driver_write_text(tf, from);
     }
-    else if (*(int *)File->private_data == 2)
+
+    if (ret > 0)
     {
-        printk("The minor who called write is minor 2\n");
-        value = &GREEN;
-        status = GREEN_e;
+        tera_pmu_add(TERA_PMU_BYTES_WRITTEN, ret);
     }
+    ns = tera_stats_op(&tf->led->stats, TERA_PATH_WRITE, ret, count, start);
+    trace_tera_write(file_inode(File)->i_rdev, count, ret, ns);
+    return ret;
+}
 
-    /*
-     * Copy data from user space to kernel space.
-     */
-    not_copied = copy_from_user(value, user_buffer, sizeof(RED_1));
+/*
+ * Function: tera_gpio_account
+ * ---------------------------
+ * Records one GPIO set operation for every pin in the mask, the bytes
+ * counter of the gpio_set path counts pin updates.
+ */
+static void tera_gpio_account(u32 mask, u32 value, u64 start)
+{
+    struct tera_led *led;
+    int pin;
+    u64 ns;
 
-    /*
-     * Process the data and perform corresponding actions.
-     */
-    switch ((*value)[0])
-    {
-    case '0':
-        gpio_set_value(status, 0);
-        printk("gpio clear is done\n");
-        break;
-    case '1':
-        gpio_set_value(status, 1);
-        printk("gpio set is done\n");
-        break;
-    default:
-        printk("gpio Invalid input\n");
-        break;
+    rcu_read_lock();
+    for (pin = 0; pin < TERA_GPIO_MAX_PINS; pin++)
+    {
+        led = rcu_dereference(tera_leds[pin]);
+        if ((mask & BIT(pin)) && led)
+        {
+            tera_pmu_add(TERA_PMU_GPIO_TOGGLES, 1);
+            ns = tera_stats_op(&led->stats, TERA_PATH_GPIO_SET, 1, 1, start);
+            trace_tera_gpio_set(pin, led->gpio, !!(value & BIT(pin)), ns);
+        }
     }
+    rcu_read_unlock();
+}
 
-    /*
-     * Adjust the count based on the bytes successfully written.
-     */
-    count = count - not_copied;
-    return count;
+/*
+ * Function: tera_gpio_write
+ * -------------------------
+ * Drives one LED. Pins on controllers that can sleep (I2C/SPI expanders)
+ * are handed to the flush worker, which coalesces back-to-back writes into
+ * one bus transaction, so the caller does not wait for the bus. With the
+ * realtime worker enabled every update goes through its queue instead.
+ */
+void tera_gpio_write(int pin, int value)
+{
+    u64 start = tera_stats_start();
+    struct gpio_desc *desc = tera_gpio_desc(pin);
+
+    if (desc == NULL)
+    {
+        return; // Unbound meanwhile
+    }
+
+    if (gpio_rt_submit(BIT(pin), value ? BIT(pin) : 0))
+    {
+        // Queued for the realtime worker
+    }
+    else if (gpiod_cansleep(desc))
+    {
+        gpio_flush_submit(BIT(pin), value ? BIT(pin) : 0);
+    }
+    else
+    {
+        gpiod_set_raw_value(desc, value);
+    }
+    tera_gpio_account(BIT(pin), value ? BIT(pin) : 0, start);
 }
 
 
@@ -153,8 +349,335 @@ ssize_t driver_write(struct file *File, const char *user_buffer, size_t count, l
  * ---------------------
  * Called when data is read from a device file.
  */
-ssize_t driver_read(struct file *File, char *user_buffer, size_t count, loff_t *offs)
+ssize_t driver_read(struct kiocb *iocb, struct iov_iter *to)
 {
-    printk("read function is called but this pin is just output\n");
+    struct file *File = iocb->ki_filp;
+    struct tera_file *tf = File->private_data;
+    size_t count = iov_iter_count(to);
+    u64 ns;
+
+    /* The LEDs are outputs only */
+    ns = tera_stats_op(&tf->led->stats, TERA_PATH_READ, -ENOSYS, count, tera_stats_start());
+    trace_tera_read(file_inode(File)->i_rdev, count, -ENOSYS, ns);
     return -ENOSYS;
 }
+
+
+/*
+ * Function: driver_ioctl_levels
+ * -----------------------------
+ * Handles TERA_GPIO_IOC_GET, TERA_GPIO_IOC_SET and TERA_GPIO_IOC_TOGGLE.
+ */
+static long driver_ioctl_levels(unsigned int cmd, struct tera_gpio_levels __user *ulevels)
+{
+    struct tera_gpio_levels levels;
+    struct tera_gpio_op op = {0};
+    int ret;
+
+    if (cmd == TERA_GPIO_IOC_GET)
+    {
+        levels.mask = tera_gpio_probed_mask();
+        ret = tera_gpio_bank_read(levels.mask, &levels.value);
+        if (ret)
+        {
+            return ret;
+        }
+        return copy_to_user(ulevels, &levels, sizeof(levels)) ? -EFAULT : 0;
+    }
+
+    if (copy_from_user(&levels, ulevels, sizeof(levels)))
+    {
+        return -EFAULT;
+    }
+    op.op = cmd == TERA_GPIO_IOC_SET ? TERA_GPIO_OP_MASK : TERA_GPIO_OP_TOGGLE;
+    op.mask = levels.mask;
+    op.value = levels.value;
+    return tera_gpio_apply_op(&op);
+}
+
+/*
+ * Function: driver_ioctl
+ * ----------------------
+ * Called for ioctl requests on a device file. The timed command queue and
+ * the level requests use pin masks, so they do not depend on the minor.
+ *
+ * Parameters:
+ * - File: Pointer to the file structure representing the device file.
+ * - cmd: ioctl request code.
+ * - arg: Request argument, usually a user pointer.
+ *
+ * Returns:
+ * - 0 on success, otherwise an error code.
+ */
+long driver_ioctl(struct file *File, unsigned int cmd, unsigned long arg)
+{
+    struct tera_file *tf = File->private_data;
+    long ret;
+    u32 mode;
+
+    switch (cmd)
+    {
+    case TERA_GPIO_IOC_FLUSH:
+        gpio_rt_sync();
+        gpio_flush_sync();
+        return 0;
+    case TERA_GPIO_IOC_SET_MODE:
+        if (get_user(mode, (u32 __user *)arg))
+        {
+            return -EFAULT;
+        }
+        if (mode != TERA_GPIO_MODE_TEXT && mode != TERA_GPIO_MODE_BINARY)
+        {
+            return -EINVAL;
+        }
+        tf->mode = mode;
+        return 0;
+    case TERA_GPIO_IOC_GET:
+    case TERA_GPIO_IOC_SET:
+    case TERA_GPIO_IOC_TOGGLE:
+        return driver_ioctl_levels(cmd, (struct tera_gpio_levels __user *)arg);
+    default:
+        ret = gpio_queue_ioctl(cmd, arg);
+        if (ret == -ENOSPC)
+        {
+            tera_stats_add(&tf->led->stats, TERA_PATH_WRITE, TERA_STAT_DROPS, 1); // Batch rejected, queue full
+            tera_pmu_add(TERA_PMU_BUFFER_FULL, 1);
+        }
+        return ret;
+    }
+}
+
+/*
+ * Function: driver_fsync
+ * ----------------------
+ * Called when a device file is synced. Waits until every write queued for
+ * a sleeping GPIO controller reached the pins.
+ */
+int driver_fsync(struct file *File, loff_t start, loff_t end, int datasync)
+{
+    gpio_rt_sync();
+    gpio_flush_sync();
+    return 0;
+}
+
+bool tera_gpio_mask_ready(u32 mask)
+{
+    int pin;
+
+    for (pin = 0; pin < TERA_GPIO_MAX_PINS; pin++)
+    {
+        if ((mask & BIT(pin)) && tera_gpio_desc(pin) == NULL)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+u32 tera_gpio_probed_mask(void)
+{
+    u32 mask = 0;
+    int pin;
+
+    for (pin = 0; pin < TERA_GPIO_MAX_PINS; pin++)
+    {
+        if (tera_gpio_desc(pin))
+        {
+            mask |= BIT(pin);
+        }
+    }
+    return mask;
+}
+
+u32 tera_gpio_sleep_mask(u32 mask)
+{
+    struct gpio_desc *desc;
+    u32 sleep = 0;
+    int pin;
+
+    for (pin = 0; pin < TERA_GPIO_MAX_PINS; pin++)
+    {
+        desc = (mask & BIT(pin)) ? tera_gpio_desc(pin) : NULL;
+        if (desc && gpiod_cansleep(desc))
+        {
+            sleep |= BIT(pin);
+        }
+    }
+    return sleep;
+}
+
+/*
+ * Function: tera_gpio_pack
+ * ------------------------
+ * Packs the pins selected by mask into a descriptor array and a value
+ * bitmap, so gpiolib can write each controller in one transaction.
+ *
+ * Returns:
+ * - Number of packed pins, or -ENODEV when a pin is not probed.
+ */
+static int tera_gpio_pack(u32 mask, u32 value, struct gpio_desc **descs, unsigned long *values)
+{
+    int pin, n = 0;
+
+    bitmap_zero(values, TERA_GPIO_MAX_PINS);
+
+    for (pin = 0; pin < TERA_GPIO_MAX_PINS; pin++)
+    {
+        if (!(mask & BIT(pin)))
+        {
+            continue;
+        }
+        descs[n] = tera_gpio_desc(pin);
+        if (descs[n] == NULL)
+        {
+            return -ENODEV;
+        }
+        if (value & BIT(pin))
+        {
+            __set_bit(n, values);
+        }
+        n++;
+    }
+    return n;
+}
+
+int tera_gpio_bank_write(u32 mask, u32 value)
+{
+    struct gpio_desc *descs[TERA_GPIO_MAX_PINS];
+    DECLARE_BITMAP(values, TERA_GPIO_MAX_PINS);
+    int n = tera_gpio_pack(mask, value, descs, values);
+
+    if (n <= 0)
+    {
+        return n;
+    }
+    return gpiod_set_raw_array_value(n, descs, NULL, values);
+}
+
+int tera_gpio_bank_write_cansleep(u32 mask, u32 value)
+{
+    struct gpio_desc *descs[TERA_GPIO_MAX_PINS];
+    DECLARE_BITMAP(values, TERA_GPIO_MAX_PINS);
+    int n = tera_gpio_pack(mask, value, descs, values);
+
+    if (n <= 0)
+    {
+        return n;
+    }
+    return gpiod_set_raw_array_value_cansleep(n, descs, NULL, values);
+}
+
+int tera_gpio_bank_read(u32 mask, u32 *value)
+{
+    struct gpio_desc *descs[TERA_GPIO_MAX_PINS];
+    DECLARE_BITMAP(values, TERA_GPIO_MAX_PINS);
+    int i, pin, ret, n = tera_gpio_pack(mask, 0, descs, values);
+
+    *value = 0;
+    if (n <= 0)
+    {
+        return n;
+    }
+
+    /* Pending queued and coalesced writes must land first, or the read is stale */
+    gpio_rt_sync();
+    if (tera_gpio_sleep_mask(mask))
+    {
+        gpio_flush_sync();
+    }
+
+    ret = gpiod_get_raw_array_value_cansleep(n, descs, NULL, values);
+    if (ret)
+    {
+        return ret;
+    }
+
+    /* Unpack the bitmap back to pin positions */
+    for (i = 0, pin = 0; pin < TERA_GPIO_MAX_PINS; pin++)
+    {
+        if (mask & BIT(pin))
+        {
+            if (test_bit(i, values))
+            {
+                *value |= BIT(pin);
+            }
+            i++;
+        }
+    }
+    return 0;
+}
+
+void tera_gpio_set_mask(u32 mask, u32 value)
+{
+    u64 start = tera_stats_start();
+    u32 sleep;
+
+    if (gpio_rt_submit(mask, value))
+    {
+        // Queued for the realtime worker
+    }
+    else
+    {
+        // Only the pins on sleeping controllers wait for the flush worker
+        sleep = tera_gpio_sleep_mask(mask);
+        if (mask & ~sleep)
+        {
+            tera_gpio_bank_write(mask & ~sleep, value);
+        }
+        if (sleep)
+        {
+            gpio_flush_submit(sleep, value);
+        }
+    }
+    tera_gpio_account(mask, value, start);
+}
+
+/*
+ * tera_gpio_toggle_lock: Serialises the read and the write of a toggle, so
+ * two concurrent toggles of a pin invert it twice instead of once.
+ */
+static DEFINE_MUTEX(tera_gpio_toggle_lock);
+
+int tera_gpio_apply_op(const struct tera_gpio_op *op)
+{
+    u32 levels;
+    int ret;
+
+    if (op->reserved)
+    {
+        return -EINVAL; // Keep the field free for later use
+    }
+
+    switch (op->op)
+    {
+    case TERA_GPIO_OP_PIN:
+        if (op->pin >= TERA_GPIO_MAX_PINS || !tera_gpio_mask_ready(BIT(op->pin)))
+        {
+            return -EINVAL;
+        }
+        tera_gpio_set_mask(BIT(op->pin), op->value ? BIT(op->pin) : 0);
+        return 0;
+    case TERA_GPIO_OP_MASK:
+        if ((op->mask & ~TERA_GPIO_MASK_ALL) || !tera_gpio_mask_ready(op->mask))
+        {
+            return -EINVAL;
+        }
+        tera_gpio_set_mask(op->mask, op->value);
+        return 0;
+    case TERA_GPIO_OP_TOGGLE:
+        if ((op->mask & ~TERA_GPIO_MASK_ALL) || !tera_gpio_mask_ready(op->mask))
+        {
+            return -EINVAL;
+        }
+        mutex_lock(&tera_gpio_toggle_lock);
+        ret = tera_gpio_bank_read(op->mask, &levels);
+        if (ret == 0)
+        {
+            tera_gpio_set_mask(op->mask, ~levels);
+        }
+        mutex_unlock(&tera_gpio_toggle_lock);
+        return ret;
+    default:
+        return -EINVAL;
+    }
+}
@@ -16,6 +16,16 @@
 #include <linux/mod_devicetable.h>
 #include <linux/gpio.h>
 #include <linux/string.h>
+#include <linux/gpio/consumer.h>
+#include <linux/bitmap.h>
+#include <linux/uio.h>
+#include <linux/kref.h>
+#include <linux/rcupdate.h>
+#include <linux/leds.h>
+#include "tera_gpio_uapi.h"
+#include "../common/tera_stats.h"
+#include "../common/tera_trace.h"
+#include "../common/tera_pmu.h"
 
 /*
  * Enum: devices_name
@@ -29,6 +39,129 @@ enum devices_name
     LED_GREEN
 };
 
+/*
+ * TERA_GPIO_BASE: Default of the gpio_base module parameter, the GPIO
+ * number of the first LED. The device with minor N drives GPIO
+ * gpio_base + N.
+ */
+#define TERA_GPIO_BASE 2
+
+/*
+ * Struct: tera_led
+ * ----------------
+ * State of one probed LED. Probe allocates it and every open device file
+ * holds a reference, so the counters of a file stay valid when its LED is
+ * unbound meanwhile. The memory is freed after an RCU grace period, so the
+ * paths that walk pin masks only need rcu_read_lock.
+ */
+struct tera_led
+{
+    int pin;                  /* Minor number, also the bit of the LED in the pin masks */
+    int gpio;                 /* Legacy GPIO number, gpio_base + pin */
+    struct gpio_desc *desc;   /* The pin, valid until the device is unbound */
+    struct tera_stats stats;  /* Counters and latency histograms, in debugfs under tera/teraGPIO/<LED name>/ */
+    struct led_classdev cdev; /* LED class device, see tera_led.c */
+    struct kref ref;          /* References of probe and of the open files */
+    struct rcu_head rcu;
+};
+
+/*
+ * Array: tera_leds
+ * ----------------
+ * Probed LEDs indexed by minor number, NULL while the matching platform
+ * device is not probed. Only the lookup from a pin mask to its LEDs lives
+ * here, the state itself is in struct tera_led.
+ */
+extern struct tera_led __rcu *tera_leds[TERA_GPIO_MAX_PINS];
+
+/*
+ * Function: tera_led_put
+ * ----------------------
+ * Drops a reference to a LED.
+ */
+void tera_led_put(struct tera_led *led);
+
+/*
+ * Function: tera_gpio_desc
+ * ------------------------
+ * GPIO descriptor of the LED with the given minor number, NULL while it is
+ * not probed. Safe to call from any context.
+ */
+struct gpio_desc *tera_gpio_desc(int pin);
+
+/*
+ * Function: tera_gpio_mask_ready
+ * ------------------------------
+ * Checks that every pin in the mask belongs to a probed device.
+ */
+bool tera_gpio_mask_ready(u32 mask);
+
+/*
+ * Function: tera_gpio_sleep_mask
+ * ------------------------------
+ * Returns the pins of mask that sit on a controller that can sleep, the
+ * others can be written from atomic context.
+ */
+u32 tera_gpio_sleep_mask(u32 mask);
+
+/*
+ * Function: tera_gpio_bank_write
+ * ------------------------------
+ * Drives every pin in mask to the matching bit of value with a single
+ * array write. Safe to call from atomic context.
+ */
+int tera_gpio_bank_write(u32 mask, u32 value);
+
+/*
+ * Function: tera_gpio_bank_write_cansleep
+ * ---------------------------------------
+ * Same as tera_gpio_bank_write for controllers that can sleep, one bus
+ * transaction per controller. Process context only.
+ */
+int tera_gpio_bank_write_cansleep(u32 mask, u32 value);
+
+/*
+ * Function: tera_gpio_write
+ * -------------------------
+ * Drives the LED with the given minor number.
+ */
+void tera_gpio_write(int pin, int value);
+
+/*
+ * Function: tera_gpio_probed_mask
+ * -------------------------------
+ * Returns the mask of the pins whose platform device is probed.
+ */
+u32 tera_gpio_probed_mask(void);
+
+/*
+ * Function: tera_gpio_bank_read
+ * -----------------------------
+ * Reads the level of every pin in mask. Process context only.
+ *
+ * Returns:
+ * - 0 on success, otherwise an error code.
+ */
+int tera_gpio_bank_read(u32 mask, u32 *value);
+
+/*
+ * Function: tera_gpio_set_mask
+ * ----------------------------
+ * Drives the pins in mask. Pins on controllers that can sleep go through
+ * the flush worker, the others are written right away.
+ */
+void tera_gpio_set_mask(u32 mask, u32 value);
+
+/*
+ * Function: tera_gpio_apply_op
+ * ----------------------------
+ * Validates and executes one binary protocol op.
+ *
+ * Returns:
+ * - 0 on success, otherwise an error code.
+ */
+int tera_gpio_apply_op(const struct tera_gpio_op *op);
+
 /*
  * Function: driver_open
  * ---------------------
@@ -46,15 +179,31 @@ int driver_close(struct inode *device_file, struct file *instance);
 /*
  * Function: driver_write
  * ----------------------
- * Called when data is written to a device file.
+ * Called when data is written to a device file, by write() or by
+ * kernel_write().
  */
-ssize_t driver_write(struct file *File, const char *user_buffer, size_t count, loff_t *offs);
+ssize_t driver_write(struct kiocb *iocb, struct iov_iter *from);
 
 /*
  * Function: driver_read
  * ---------------------
- * Called when data is read from a device file.
+ * Called when data is read from a device file, by read() or by
+ * kernel_read().
+ */
+ssize_t driver_read(struct kiocb *iocb, struct iov_iter *to);
+
+/*
+ * Function: driver_ioctl
+ * ----------------------
+ * Called for ioctl requests on a device file.
+ */
+long driver_ioctl(struct file *File, unsigned int cmd, unsigned long arg);
+
+/*
+ * Function: driver_fsync
+ * ----------------------
+ * Called when a device file is synced.
  */
-ssize_t driver_read(struct file *File,char *user_buffer, size_t count, loff_t *offs);
+int driver_fsync(struct file *File, loff_t start, loff_t end, int datasync);
 
 #endif // !FILE_OPERATION
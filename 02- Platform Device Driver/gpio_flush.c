@@ -0,0 +1,81 @@
+/*
+ * Author: Eng. Mostafa Tera
+ * Date: 19/10/2026
+ */
+
+#include <linux/workqueue.h>
+#include <linux/spinlock.h>
+#include "gpio_flush.h"
+
+/*
+ * Struct: gpio_flush
+ * ------------------
+ * Pending levels of the pins on sleeping controllers and the worker that
+ * sends them.
+ */
+static struct gpio_flush
+{
+    spinlock_t lock;               /* Protects mask and value */
+    u32 mask;                      /* Pins with a level waiting to be sent */
+    u32 value;                     /* Latest requested level of those pins */
+    struct workqueue_struct *wq;   /* Ordered, so only one flush runs at a time */
+    struct work_struct work;
+} flush;
+
+/*
+ * Function: gpio_flush_fn
+ * -----------------------
+ * Takes the pending bitmap and writes it with one array transaction per
+ * controller.
+ */
+static void gpio_flush_fn(struct work_struct *work)
+{
+    unsigned long flags;
+    u32 mask, value;
+
+    spin_lock_irqsave(&flush.lock, flags);
+    mask = flush.mask;
+    value = flush.value;
+    flush.mask = 0;
+    spin_unlock_irqrestore(&flush.lock, flags);
+
+    if (mask)
+    {
+        tera_gpio_bank_write_cansleep(mask, value);
+    }
+}
+
+void gpio_flush_submit(u32 mask, u32 value)
+{
+    unsigned long flags;
+
+    spin_lock_irqsave(&flush.lock, flags);
+    flush.value = (flush.value & ~mask) | (value & mask);
+    flush.mask |= mask;
+    spin_unlock_irqrestore(&flush.lock, flags);
+
+    queue_work(flush.wq, &flush.work);
+}
+
+void gpio_flush_sync(void)
+{
+    flush_work(&flush.work);
+}
+
+int gpio_flush_init(void)
+{
+    spin_lock_init(&flush.lock);
+    INIT_WORK(&flush.work, gpio_flush_fn);
+
+    flush.wq = alloc_ordered_workqueue("tera_gpio_flush", WQ_HIGHPRI);
+    if (flush.wq == NULL)
+    {
+        return -ENOMEM;
+    }
+    return 0;
+}
+
+void gpio_flush_exit(void)
+{
+    destroy_workqueue(flush.wq); // Drains the pending flush first
+}
@@ -0,0 +1,44 @@
+/*
+ * Author: Eng. Mostafa Tera
+ * Date: 19/10/2026
+ */
+
+#ifndef GPIO_FLUSH
+#define GPIO_FLUSH
+
+#include "file_operations.h"
+
+/*
+ * Function: gpio_flush_init
+ * -------------------------
+ * Creates the high priority workqueue that writes sleeping controllers.
+ *
+ * Returns:
+ * - 0 on success, otherwise an error code.
+ */
+int gpio_flush_init(void);
+
+/*
+ * Function: gpio_flush_exit
+ * -------------------------
+ * Applies the pending writes and destroys the workqueue.
+ */
+void gpio_flush_exit(void);
+
+/*
+ * Function: gpio_flush_submit
+ * ---------------------------
+ * Records the new level of the pins in mask and returns at once. Writes that
+ * arrive before the worker runs are merged, only the latest level is sent.
+ * Safe to call from atomic context.
+ */
+void gpio_flush_submit(u32 mask, u32 value);
+
+/*
+ * Function: gpio_flush_sync
+ * -------------------------
+ * Waits until every submitted write reached the pins.
+ */
+void gpio_flush_sync(void);
+
+#endif // !GPIO_FLUSH
@@ -0,0 +1,463 @@
+/*
+ * Author: Eng. Mostafa Tera
+ * Date: 19/10/2026
+ */
+
+#include <linux/hrtimer.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+#include "gpio_queue.h"
+#include "gpio_flush.h"
+
+/*
+ * queue_overrun_ns: A command applied later than this is counted as an overrun.
+ */
+static unsigned long queue_overrun_ns = 50000;
+module_param(queue_overrun_ns, ulong, 0644);
+MODULE_PARM_DESC(queue_overrun_ns, "Lateness in ns after which a queued command counts as an overrun");
+
+/*
+ * Struct: gpio_queue
+ * ------------------
+ * Ring of timed commands consumed by a hard hrtimer, plus the optional
+ * repeating pattern that replaces the ring while it runs.
+ */
+static struct gpio_queue
+{
+    spinlock_t lock;                  /* Protects everything below against the timer */
+    struct hrtimer timer;             /* Fires at the time of the next command */
+    struct tera_gpio_cmd ring[TERA_QUEUE_DEPTH];
+    unsigned int head;                /* Next command to apply */
+    unsigned int tail;                /* Next free slot */
+
+    bool pattern_active;              /* The pattern is running instead of the ring */
+    struct tera_gpio_cmd steps[TERA_QUEUE_PATTERN_MAX];
+    unsigned int step_count;
+    unsigned int step;                /* Next step to apply */
+    ktime_t period_start;             /* Start of the current period */
+    u64 period_ns;
+    u32 repeat;                       /* Periods left, 0 = forever */
+
+    struct tera_gpio_queue_stats stats;
+} queue;
+
+/*
+ * Function: queue_pending
+ * -----------------------
+ * Number of commands waiting in the ring. Called with the lock held.
+ */
+static unsigned int queue_pending(void)
+{
+    return queue.tail - queue.head;
+}
+
+/*
+ * Function: queue_next_expiry
+ * ---------------------------
+ * Time of the next command to apply. Called with the lock held and only
+ * when there is something to apply.
+ */
+static ktime_t queue_next_expiry(void)
+{
+    if (queue.pattern_active)
+    {
+        return ktime_add_ns(queue.period_start, queue.steps[queue.step].time_ns);
+    }
+    return ns_to_ktime(queue.ring[queue.head & (TERA_QUEUE_DEPTH - 1)].time_ns);
+}
+
+/*
+ * Function: queue_account
+ * -----------------------
+ * Records the lateness of one applied command. Called with the lock held.
+ */
+static void queue_account(ktime_t now, ktime_t due)
+{
+    u64 late = ktime_after(now, due) ? ktime_to_ns(ktime_sub(now, due)) : 0;
+
+    queue.stats.applied++;
+    queue.stats.total_late_ns += late;
+    if (late > queue.stats.max_late_ns)
+    {
+        queue.stats.max_late_ns = late;
+    }
+    if (late > queue_overrun_ns)
+    {
+        queue.stats.overruns++;
+    }
+}
+
+/*
+ * Function: queue_timer_fn
+ * ------------------------
+ * hrtimer callback. Merges every command that is due into a single bank
+ * write, then re-arms the timer for the next one.
+ */
+static enum hrtimer_restart queue_timer_fn(struct hrtimer *timer)
+{
+    enum hrtimer_restart restart = HRTIMER_NORESTART;
+    ktime_t now = ktime_get();
+    u32 mask = 0, value = 0, sleep;
+    unsigned long flags;
+
+    spin_lock_irqsave(&queue.lock, flags);
+
+    if (queue.pattern_active)
+    {
+        /* Apply at most one period per callback to bound the time spent in hardirq */
+        unsigned int budget = queue.step_count;
+
+        while (budget-- && !ktime_after(queue_next_expiry(), now))
+        {
+            struct tera_gpio_cmd *step = &queue.steps[queue.step];
+
+            queue_account(now, queue_next_expiry());
+            value = (value & ~step->mask) | (step->value & step->mask);
+            mask |= step->mask;
+
+            if (++queue.step == queue.step_count)
+            {
+                queue.step = 0;
+                queue.period_start = ktime_add_ns(queue.period_start, queue.period_ns);
+                if (queue.repeat && --queue.repeat == 0)
+                {
+                    queue.pattern_active = false;
+                    break;
+                }
+            }
+        }
+        queue.stats.pattern = queue.pattern_active;
+    }
+    else
+    {
+        while (queue_pending() && !ktime_after(queue_next_expiry(), now))
+        {
+            struct tera_gpio_cmd *cmd = &queue.ring[queue.head & (TERA_QUEUE_DEPTH - 1)];
+
+            queue_account(now, ns_to_ktime(cmd->time_ns));
+            value = (value & ~cmd->mask) | (cmd->value & cmd->mask);
+            mask |= cmd->mask;
+            queue.head++;
+        }
+    }
+
+    sleep = tera_gpio_sleep_mask(mask);
+    if (mask & ~sleep)
+    {
+        tera_gpio_bank_write(mask & ~sleep, value);
+    }
+    if (sleep)
+    {
+        gpio_flush_submit(sleep, value); // Expanders can not be written from hardirq
+    }
+
+    if (queue.pattern_active || queue_pending())
+    {
+        hrtimer_set_expires(timer, queue_next_expiry());
+        restart = HRTIMER_RESTART;
+    }
+    queue.stats.pending = queue_pending();
+
+    spin_unlock_irqrestore(&queue.lock, flags);
+    return restart;
+}
+
+/*
+ * Function: queue_copy_cmds
+ * -------------------------
+ * Copies and validates an array of commands from user space. Commands must
+ * be sorted by time, use only known pins and target probed devices.
+ *
+ * Returns:
+ * - A kmalloc'ed array on success, otherwise an ERR_PTR.
+ */
+static struct tera_gpio_cmd *queue_copy_cmds(u64 uptr, u32 count, u32 max)
+{
+    struct tera_gpio_cmd *cmds;
+    u32 i;
+
+    if (count == 0 || count > max)
+    {
+        return ERR_PTR(-EINVAL);
+    }
+
+    cmds = memdup_user(u64_to_user_ptr(uptr), count * sizeof(*cmds));
+    if (IS_ERR(cmds))
+    {
+        return cmds;
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        if ((cmds[i].mask & ~TERA_GPIO_MASK_ALL) || !tera_gpio_mask_ready(cmds[i].mask) ||
+            (i && cmds[i].time_ns < cmds[i - 1].time_ns))
+        {
+            kfree(cmds);
+            return ERR_PTR(-EINVAL);
+        }
+    }
+    return cmds;
+}
+
+/*
+ * Function: queue_cmds_ready
+ * --------------------------
+ * Checks again under the lock that every pin of the commands is probed, a
+ * device may have been removed since queue_copy_cmds. Called with the lock
+ * held, gpio_queue_remove_pin clears descriptors under it.
+ */
+static bool queue_cmds_ready(const struct tera_gpio_cmd *cmds, u32 count)
+{
+    u32 i;
+
+    for (i = 0; i < count; i++)
+    {
+        if (!tera_gpio_mask_ready(cmds[i].mask))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * Function: queue_submit
+ * ----------------------
+ * Appends a batch to the ring. The batch must not start before the last
+ * queued command, so the ring stays sorted without any reordering.
+ */
+static long queue_submit(struct tera_gpio_batch __user *ubatch)
+{
+    struct tera_gpio_batch batch;
+    struct tera_gpio_cmd *cmds;
+    unsigned long flags;
+    long ret = 0;
+    u32 i;
+
+    if (copy_from_user(&batch, ubatch, sizeof(batch)))
+    {
+        return -EFAULT;
+    }
+    if (batch.flags)
+    {
+        return -EINVAL;
+    }
+
+    cmds = queue_copy_cmds(batch.cmds, batch.count, TERA_QUEUE_DEPTH);
+    if (IS_ERR(cmds))
+    {
+        return PTR_ERR(cmds);
+    }
+
+    spin_lock_irqsave(&queue.lock, flags);
+
+    if (queue.pattern_active)
+    {
+        ret = -EBUSY;
+    }
+    else if (!queue_cmds_ready(cmds, batch.count))
+    {
+        ret = -ENODEV; // A pin went away meanwhile
+    }
+    else if (queue_pending() &&
+             cmds[0].time_ns < queue.ring[(queue.tail - 1) & (TERA_QUEUE_DEPTH - 1)].time_ns)
+    {
+        ret = -EINVAL;
+    }
+    else if (batch.count > TERA_QUEUE_DEPTH - queue_pending())
+    {
+        queue.stats.dropped += batch.count;
+        ret = -ENOSPC;
+    }
+    else
+    {
+        bool was_empty = queue_pending() == 0;
+
+        for (i = 0; i < batch.count; i++)
+        {
+            queue.ring[queue.tail++ & (TERA_QUEUE_DEPTH - 1)] = cmds[i];
+        }
+        queue.stats.pending = queue_pending();
+
+        if (was_empty)
+        {
+            hrtimer_start(&queue.timer, queue_next_expiry(), HRTIMER_MODE_ABS_HARD);
+        }
+    }
+
+    spin_unlock_irqrestore(&queue.lock, flags);
+
+    kfree(cmds);
+    return ret;
+}
+
+/*
+ * Function: queue_stop_locked
+ * ---------------------------
+ * Stops the timer and forgets every pending command and the pattern, with
+ * queue.lock held. A callback running on another CPU spins on the lock, so
+ * the lock is dropped while it finishes. Nothing can re-arm the timer
+ * between the cancel and the return, both happen under the lock.
+ */
+static void queue_stop_locked(unsigned long *flags)
+{
+    while (hrtimer_try_to_cancel(&queue.timer) < 0)
+    {
+        spin_unlock_irqrestore(&queue.lock, *flags);
+        cpu_relax();
+        spin_lock_irqsave(&queue.lock, *flags);
+    }
+    queue.head = queue.tail;
+    queue.pattern_active = false;
+    queue.stats.pending = 0;
+    queue.stats.pattern = 0;
+}
+
+/*
+ * Function: queue_cancel
+ * ----------------------
+ * Stops the timer and forgets every pending command and the pattern.
+ */
+static void queue_cancel(void)
+{
+    unsigned long flags;
+
+    spin_lock_irqsave(&queue.lock, flags);
+    queue_stop_locked(&flags);
+    spin_unlock_irqrestore(&queue.lock, flags);
+}
+
+/*
+ * Function: queue_pattern
+ * -----------------------
+ * Replaces the queue content with a repeating pattern.
+ */
+static long queue_pattern(struct tera_gpio_pattern __user *upattern)
+{
+    struct tera_gpio_pattern pattern;
+    struct tera_gpio_cmd *steps;
+    unsigned long flags;
+
+    if (copy_from_user(&pattern, upattern, sizeof(pattern)))
+    {
+        return -EFAULT;
+    }
+
+    steps = queue_copy_cmds(pattern.steps, pattern.count, TERA_QUEUE_PATTERN_MAX);
+    if (IS_ERR(steps))
+    {
+        return PTR_ERR(steps);
+    }
+
+    /* Every step has to fall inside the period, and the first period must not be over already */
+    if (steps[0].time_ns < 0 || (u64)steps[pattern.count - 1].time_ns >= pattern.period_ns ||
+        pattern.start_ns + (s64)pattern.period_ns < ktime_get_ns())
+    {
+        kfree(steps);
+        return -EINVAL;
+    }
+
+    /* Stop the old content and install the pattern under one lock, so a batch can not slip in between */
+    spin_lock_irqsave(&queue.lock, flags);
+    queue_stop_locked(&flags);
+    if (!queue_cmds_ready(steps, pattern.count))
+    {
+        spin_unlock_irqrestore(&queue.lock, flags);
+        kfree(steps);
+        return -ENODEV; // A pin went away meanwhile
+    }
+    memcpy(queue.steps, steps, pattern.count * sizeof(*steps));
+    queue.step_count = pattern.count;
+    queue.step = 0;
+    queue.period_start = ns_to_ktime(pattern.start_ns);
+    queue.period_ns = pattern.period_ns;
+    queue.repeat = pattern.repeat;
+    queue.pattern_active = true;
+    queue.stats.pattern = 1;
+    hrtimer_start(&queue.timer, queue_next_expiry(), HRTIMER_MODE_ABS_HARD);
+    spin_unlock_irqrestore(&queue.lock, flags);
+
+    kfree(steps);
+    return 0;
+}
+
+/*
+ * Function: queue_stats
+ * ---------------------
+ * Copies the statistics to user space, optionally resetting them.
+ */
+static long queue_stats(struct tera_gpio_queue_stats __user *ustats, bool reset)
+{
+    struct tera_gpio_queue_stats stats;
+    unsigned long flags;
+
+    spin_lock_irqsave(&queue.lock, flags);
+    stats = queue.stats;
+    if (reset)
+    {
+        memset(&queue.stats, 0, sizeof(queue.stats));
+        queue.stats.pending = stats.pending;
+        queue.stats.pattern = stats.pattern;
+    }
+    spin_unlock_irqrestore(&queue.lock, flags);
+
+    if (copy_to_user(ustats, &stats, sizeof(stats)))
+    {
+        return -EFAULT;
+    }
+    return 0;
+}
+
+long gpio_queue_ioctl(unsigned int cmd, unsigned long arg)
+{
+    void __user *argp = (void __user *)arg;
+
+    switch (cmd)
+    {
+    case TERA_GPIO_IOC_QUEUE_SUBMIT:
+        return queue_submit(argp);
+    case TERA_GPIO_IOC_QUEUE_PATTERN:
+        return queue_pattern(argp);
+    case TERA_GPIO_IOC_QUEUE_CANCEL:
+        queue_cancel();
+        return 0;
+    case TERA_GPIO_IOC_QUEUE_STATS:
+        return queue_stats(argp, false);
+    case TERA_GPIO_IOC_QUEUE_STATS_RESET:
+        return queue_stats(argp, true);
+    default:
+        return -ENOTTY;
+    }
+}
+
+void gpio_queue_init(void)
+{
+    spin_lock_init(&queue.lock);
+    hrtimer_setup(&queue.timer, queue_timer_fn, CLOCK_MONOTONIC, HRTIMER_MODE_ABS_HARD);
+}
+
+void gpio_queue_remove_pin(int pin)
+{
+    unsigned long flags;
+    unsigned int i;
+
+    spin_lock_irqsave(&queue.lock, flags);
+
+    /* The timer looks the pins up under the lock, so it never sees a released one */
+    RCU_INIT_POINTER(tera_leds[pin], NULL);
+    for (i = queue.head; i != queue.tail; i++)
+    {
+        queue.ring[i & (TERA_QUEUE_DEPTH - 1)].mask &= ~BIT(pin);
+    }
+    for (i = 0; i < queue.step_count; i++)
+    {
+        queue.steps[i].mask &= ~BIT(pin);
+    }
+
+    spin_unlock_irqrestore(&queue.lock, flags);
+}
+
+void gpio_queue_exit(void)
+{
+    queue_cancel();
+}
@@ -0,0 +1,56 @@
+/*
+ * Author: Eng. Mostafa Tera
+ * Date: 19/10/2026
+ */
+
+#ifndef GPIO_QUEUE
+#define GPIO_QUEUE
+
+#include "file_operations.h"
+#include "tera_gpio_uapi.h"
+
+/*
+ * TERA_QUEUE_DEPTH: Maximum number of pending timed commands (power of two).
+ */
+#define TERA_QUEUE_DEPTH 1024
+
+/*
+ * TERA_QUEUE_PATTERN_MAX: Maximum number of steps in a repeating pattern.
+ */
+#define TERA_QUEUE_PATTERN_MAX 64
+
+/*
+ * Function: gpio_queue_init
+ * -------------------------
+ * Prepares the hrtimer that applies the queued commands.
+ */
+void gpio_queue_init(void);
+
+/*
+ * Function: gpio_queue_exit
+ * -------------------------
+ * Stops the hrtimer and drops every pending command.
+ */
+void gpio_queue_exit(void);
+
+/*
+ * Function: gpio_queue_remove_pin
+ * -------------------------------
+ * Unpublishes a removed LED from tera_leds and takes its pin out of every
+ * pending command and pattern step. The commands of the other LEDs keep
+ * running.
+ */
+void gpio_queue_remove_pin(int pin);
+
+/*
+ * Function: gpio_queue_ioctl
+ * --------------------------
+ * Handles the TERA_GPIO_IOC_QUEUE_* commands.
+ *
+ * Returns:
+ * - 0 on success, -ENOTTY for commands that are not queue commands,
+ *   otherwise an error code.
+ */
+long gpio_queue_ioctl(unsigned int cmd, unsigned long arg);
+
+#endif // !GPIO_QUEUE
@@ -0,0 +1,420 @@
+/*
+ * Author: Eng. Mostafa Tera
+ * Date: 19/10/2026
+ */
+
+#include <linux/kthread.h>
+#include <linux/sched.h>
+#include <linux/sched/types.h>
+#include <linux/rwsem.h>
+#include <linux/cpumask.h>
+#include "gpio_rt.h"
+
+/*
+ * Struct: gpio_rt_cmd
+ * -------------------
+ * One queued pin update.
+ */
+struct gpio_rt_cmd
+{
+    u32 mask;
+    u32 value;
+    u64 submit_ns; /* Time the writer queued it, start of the latency */
+};
+
+/*
+ * Struct: gpio_rt
+ * ---------------
+ * Ring between the writers and a SCHED_FIFO kthread. The writers are
+ * serialised by produce_lock and hold gate shared, which makes them one
+ * producer. The kthread takes no lock at all: it only reads head and
+ * publishes tail, so a writer never waits for the worker except for room.
+ */
+static struct gpio_rt
+{
+    struct mutex lock;             /* Serialises enable/disable and setting changes */
+    struct rw_semaphore gate;      /* Writers hold it shared, disable exclusive */
+    struct task_struct *task;      /* The worker, NULL while disabled */
+    int cpu;                       /* CPU the worker is pinned to */
+    int priority;                  /* SCHED_FIFO priority of the worker */
+
+    struct mutex produce_lock;     /* Serialises the writers */
+    struct gpio_rt_cmd ring[GPIO_RT_DEPTH];
+    unsigned int head;             /* Written only by writers */
+    unsigned int tail;             /* Written only by the worker */
+    wait_queue_head_t space_wait;  /* Writers waiting for room, gpio_rt_sync */
+
+    u64 hist[GPIO_RT_HIST_BUCKETS]; /* Written only by the worker */
+    u64 max_ns;
+} rt;
+
+/*
+ * Function: gpio_rt_apply
+ * -----------------------
+ * Writes one update and records its write-to-edge latency.
+ */
+static void gpio_rt_apply(const struct gpio_rt_cmd *cmd)
+{
+    u64 latency;
+
+    if (tera_gpio_sleep_mask(cmd->mask))
+    {
+        tera_gpio_bank_write_cansleep(cmd->mask, cmd->value);
+    }
+    else
+    {
+        tera_gpio_bank_write(cmd->mask, cmd->value);
+    }
+
+    latency = ktime_get_ns() - cmd->submit_ns;
+    rt.hist[min_t(u64, latency / NSEC_PER_USEC, GPIO_RT_HIST_BUCKETS - 1)]++;
+    if (latency > rt.max_ns)
+    {
+        rt.max_ns = latency;
+    }
+}
+
+/*
+ * Function: gpio_rt_drain
+ * -----------------------
+ * Applies every queued update in order.
+ */
+static void gpio_rt_drain(void)
+{
+    unsigned int tail = rt.tail;
+
+    while (tail != smp_load_acquire(&rt.head))
+    {
+        gpio_rt_apply(&rt.ring[tail & (GPIO_RT_DEPTH - 1)]);
+        tail++;
+        smp_store_release(&rt.tail, tail); // Hand the slot back to the writers
+    }
+    wake_up(&rt.space_wait);
+}
+
+/*
+ * Function: gpio_rt_thread
+ * ------------------------
+ * Body of the realtime worker. Sleeps until a writer queues an update.
+ */
+static int gpio_rt_thread(void *data)
+{
+    for (;;)
+    {
+        // Sleeping state first, so a kthread_stop or submit after the checks still wakes us
+        set_current_state(TASK_INTERRUPTIBLE);
+        if (kthread_should_stop())
+        {
+            break;
+        }
+        if (smp_load_acquire(&rt.head) == rt.tail)
+        {
+            schedule();
+            continue;
+        }
+        __set_current_state(TASK_RUNNING);
+        gpio_rt_drain();
+    }
+    __set_current_state(TASK_RUNNING);
+
+    gpio_rt_drain(); // Updates queued right before the stop
+    return 0;
+}
+
+/*
+ * Function: gpio_rt_configure
+ * ---------------------------
+ * Applies the priority setting to the worker. Called with rt.lock held.
+ */
+static int gpio_rt_configure(void)
+{
+    struct sched_attr attr = {
+        .size = sizeof(attr),
+        .sched_policy = SCHED_FIFO,
+        .sched_priority = rt.priority,
+    };
+
+    return sched_setattr_nocheck(rt.task, &attr);
+}
+
+/*
+ * Function: gpio_rt_start
+ * -----------------------
+ * Creates the worker and binds it to rt.cpu before it first runs, so user
+ * space cannot move it afterwards. Called with rt.lock held.
+ */
+static int gpio_rt_start(void)
+{
+    int ret;
+
+    rt.task = kthread_create(gpio_rt_thread, NULL, "tera_gpio_rt");
+    if (IS_ERR(rt.task))
+    {
+        ret = PTR_ERR(rt.task);
+        rt.task = NULL;
+        return ret;
+    }
+
+    ret = gpio_rt_configure();
+    if (ret)
+    {
+        kthread_stop(rt.task);
+        rt.task = NULL;
+        return ret;
+    }
+
+    kthread_bind(rt.task, rt.cpu);
+    wake_up_process(rt.task);
+    return 0;
+}
+
+/*
+ * Function: gpio_rt_stop
+ * ----------------------
+ * Waits for the writers to leave, then stops the worker once it applied
+ * everything. Called with rt.lock held.
+ */
+static void gpio_rt_stop(void)
+{
+    struct task_struct *task;
+
+    down_write(&rt.gate);
+    task = rt.task;
+    WRITE_ONCE(rt.task, NULL);
+    up_write(&rt.gate);
+
+    if (task)
+    {
+        kthread_stop(task);
+    }
+}
+
+bool gpio_rt_submit(u32 mask, u32 value)
+{
+    struct gpio_rt_cmd *cmd;
+
+    if (READ_ONCE(rt.task) == NULL)
+    {
+        return false;
+    }
+
+    down_read(&rt.gate);
+    if (rt.task == NULL)
+    {
+        up_read(&rt.gate);
+        return false;
+    }
+
+    mutex_lock(&rt.produce_lock);
+    wait_event(rt.space_wait, rt.head - smp_load_acquire(&rt.tail) < GPIO_RT_DEPTH);
+
+    cmd = &rt.ring[rt.head & (GPIO_RT_DEPTH - 1)];
+    cmd->mask = mask;
+    cmd->value = value;
+    cmd->submit_ns = ktime_get_ns();
+    smp_store_release(&rt.head, rt.head + 1);
+    wake_up_process(rt.task);
+
+    mutex_unlock(&rt.produce_lock);
+    up_read(&rt.gate);
+    return true;
+}
+
+void gpio_rt_sync(void)
+{
+    wait_event(rt.space_wait, smp_load_acquire(&rt.tail) == READ_ONCE(rt.head));
+}
+
+/*
+ * Function: gpio_rt_percentile
+ * ----------------------------
+ * Latency in microseconds below which permille of the samples fall.
+ */
+static u64 gpio_rt_percentile(const u64 *hist, u64 count, unsigned int permille)
+{
+    u64 target = div_u64(count * permille + 999, 1000);
+    u64 seen = 0;
+    int i;
+
+    for (i = 0; i < GPIO_RT_HIST_BUCKETS; i++)
+    {
+        seen += hist[i];
+        if (seen >= target)
+        {
+            return i + 1;
+        }
+    }
+    return GPIO_RT_HIST_BUCKETS;
+}
+
+static ssize_t rt_enable_show(struct device_driver *driver, char *buf)
+{
+    return sysfs_emit(buf, "%d\n", READ_ONCE(rt.task) != NULL);
+}
+
+static ssize_t rt_enable_store(struct device_driver *driver, const char *buf, size_t count)
+{
+    bool enable;
+    int ret = 0;
+
+    if (kstrtobool(buf, &enable))
+    {
+        return -EINVAL;
+    }
+
+    mutex_lock(&rt.lock);
+    if (enable && rt.task == NULL)
+    {
+        ret = gpio_rt_start();
+    }
+    else if (!enable && rt.task)
+    {
+        gpio_rt_stop();
+    }
+    mutex_unlock(&rt.lock);
+
+    return ret ? ret : count;
+}
+static DRIVER_ATTR_RW(rt_enable);
+
+static ssize_t rt_cpu_show(struct device_driver *driver, char *buf)
+{
+    return sysfs_emit(buf, "%d\n", rt.cpu);
+}
+
+static ssize_t rt_cpu_store(struct device_driver *driver, const char *buf, size_t count)
+{
+    int cpu, ret = 0;
+
+    if (kstrtoint(buf, 0, &cpu) || cpu < 0 || cpu >= nr_cpu_ids || !cpu_online(cpu))
+    {
+        return -EINVAL;
+    }
+
+    mutex_lock(&rt.lock);
+    rt.cpu = cpu;
+    if (rt.task && task_cpu(rt.task) != cpu)
+    {
+        // A bound kthread cannot migrate, restart it on the new CPU
+        gpio_rt_stop();
+        ret = gpio_rt_start();
+    }
+    mutex_unlock(&rt.lock);
+
+    return ret ? ret : count;
+}
+static DRIVER_ATTR_RW(rt_cpu);
+
+static ssize_t rt_priority_show(struct device_driver *driver, char *buf)
+{
+    return sysfs_emit(buf, "%d\n", rt.priority);
+}
+
+static ssize_t rt_priority_store(struct device_driver *driver, const char *buf, size_t count)
+{
+    int priority, ret = 0;
+
+    if (kstrtoint(buf, 0, &priority) || priority < 1 || priority > MAX_RT_PRIO - 1)
+    {
+        return -EINVAL;
+    }
+
+    mutex_lock(&rt.lock);
+    rt.priority = priority;
+    if (rt.task)
+    {
+        ret = gpio_rt_configure();
+    }
+    mutex_unlock(&rt.lock);
+
+    return ret ? ret : count;
+}
+static DRIVER_ATTR_RW(rt_priority);
+
+/*
+ * Function: rt_latency_show
+ * -------------------------
+ * Prints "samples p50 p90 p99 p99.9 max" of the write-to-edge latency,
+ * percentiles in microseconds (upper bucket bound), max in nanoseconds.
+ */
+static ssize_t rt_latency_show(struct device_driver *driver, char *buf)
+{
+    u64 *hist;
+    u64 count = 0;
+    ssize_t len;
+    int i;
+
+    hist = kmemdup(rt.hist, sizeof(rt.hist), GFP_KERNEL);
+    if (hist == NULL)
+    {
+        return -ENOMEM;
+    }
+    for (i = 0; i < GPIO_RT_HIST_BUCKETS; i++)
+    {
+        count += hist[i];
+    }
+
+    if (count == 0)
+    {
+        len = sysfs_emit(buf, "0 0 0 0 0 0\n");
+    }
+    else
+    {
+        len = sysfs_emit(buf, "%llu %llu %llu %llu %llu %llu\n", count,
+                         gpio_rt_percentile(hist, count, 500),
+                         gpio_rt_percentile(hist, count, 900),
+                         gpio_rt_percentile(hist, count, 990),
+                         gpio_rt_percentile(hist, count, 999),
+                         READ_ONCE(rt.max_ns));
+    }
+
+    kfree(hist);
+    return len;
+}
+
+/*
+ * Function: rt_latency_store
+ * --------------------------
+ * Any write clears the latency histogram.
+ */
+static ssize_t rt_latency_store(struct device_driver *driver, const char *buf, size_t count)
+{
+    memset(rt.hist, 0, sizeof(rt.hist));
+    WRITE_ONCE(rt.max_ns, 0);
+    return count;
+}
+static DRIVER_ATTR_RW(rt_latency);
+
+static struct attribute *gpio_rt_attrs[] = {
+    &driver_attr_rt_enable.attr,
+    &driver_attr_rt_cpu.attr,
+    &driver_attr_rt_priority.attr,
+    &driver_attr_rt_latency.attr,
+    NULL,
+};
+
+static const struct attribute_group gpio_rt_group = {
+    .attrs = gpio_rt_attrs,
+};
+
+const struct attribute_group *gpio_rt_groups[] = {
+    &gpio_rt_group,
+    NULL,
+};
+
+void gpio_rt_init(void)
+{
+    mutex_init(&rt.lock);
+    init_rwsem(&rt.gate);
+    mutex_init(&rt.produce_lock);
+    init_waitqueue_head(&rt.space_wait);
+    rt.cpu = cpumask_first(cpu_online_mask);
+    rt.priority = MAX_RT_PRIO / 2;
+}
+
+void gpio_rt_exit(void)
+{
+    mutex_lock(&rt.lock);
+    gpio_rt_stop();
+    mutex_unlock(&rt.lock);
+}
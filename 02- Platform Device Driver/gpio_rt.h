@@ -0,0 +1,63 @@
+/*
+ * Author: Eng. Mostafa Tera
+ * Date: 19/10/2026
+ */
+
+#ifndef GPIO_RT
+#define GPIO_RT
+
+#include "file_operations.h"
+
+/*
+ * GPIO_RT_DEPTH: Number of pin updates the realtime queue holds (power of two).
+ */
+#define GPIO_RT_DEPTH 256
+
+/*
+ * GPIO_RT_HIST_BUCKETS: Latency histogram size, one bucket per microsecond,
+ * the last bucket collects everything slower.
+ */
+#define GPIO_RT_HIST_BUCKETS 1024
+
+/*
+ * Array: gpio_rt_groups
+ * ---------------------
+ * Driver attributes controlling the realtime worker: rt_enable, rt_cpu,
+ * rt_priority and rt_latency.
+ */
+extern const struct attribute_group *gpio_rt_groups[];
+
+/*
+ * Function: gpio_rt_init
+ * ----------------------
+ * Prepares the realtime path, disabled until rt_enable is set.
+ */
+void gpio_rt_init(void);
+
+/*
+ * Function: gpio_rt_exit
+ * ----------------------
+ * Applies the queued updates and stops the worker.
+ */
+void gpio_rt_exit(void);
+
+/*
+ * Function: gpio_rt_submit
+ * ------------------------
+ * Queues a pin update for the realtime worker. Blocks while the queue is
+ * full. Process context only.
+ *
+ * Returns:
+ * - true when the update was queued, false when the realtime path is off
+ *   and the caller has to write the pins itself.
+ */
+bool gpio_rt_submit(u32 mask, u32 value);
+
+/*
+ * Function: gpio_rt_sync
+ * ----------------------
+ * Waits until the worker applied every queued update.
+ */
+void gpio_rt_sync(void);
+
+#endif // !GPIO_RT
@@ -4,6 +4,10 @@
  */
 
 #include "file_operations.h"
+#include "gpio_queue.h"
+#include "gpio_flush.h"
+#include "gpio_rt.h"
+#include "tera_led.h"
 
 /*
  * DRIVER_NAME: Name of the driver module.
@@ -48,24 +52,72 @@ struct mydata
         .owner = THIS_MODULE,   // Owner of the file operations
         .open = driver_open,    // Function pointer to the open function
         .release = driver_close, // Function pointer to the close function
-        .read = driver_read,    // Function pointer to the read function
-        .write = driver_write   // Function pointer to the write function
+        .read_iter = driver_read,   // Function pointer to the read function
+        .write_iter = driver_write, // Function pointer to the write function
+        .unlocked_ioctl = driver_ioctl, // Function pointer to the ioctl function
+        .fsync = driver_fsync   // Function pointer to the fsync function
     }
 };
 
 /*
- * Static array of platform device IDs.
+ * tera_debugfs: debugfs directory of the module, /sys/kernel/debug/tera/teraGPIO.
+ */
+static struct dentry *tera_debugfs;
+
+/*
+ * probe_async: Probe the LEDs in parallel with the rest of the boot.
+ */
+static bool probe_async = true;
+module_param(probe_async, bool, 0444);
+MODULE_PARM_DESC(probe_async, "Probe LED devices asynchronously (default: true)");
+
+/*
+ * gpio_base: GPIO number of LED_RED, for a chip with a dynamic base such as
+ * gpio-sim.
+ */
+static int gpio_base = TERA_GPIO_BASE;
+module_param(gpio_base, int, 0444);
+MODULE_PARM_DESC(gpio_base, "GPIO number of LED_RED, minor N drives gpio_base + N (default: 2)");
+
+/*
+ * Static array of platform device IDs. The platform device id is the minor
+ * number, the LED drives GPIO gpio_base + id.
  */
 static struct platform_device_id device_id[] =
     {
         [LED_RED] = {.name = "LED_RED"},
         [LED_RED_2] = {.name = "LED_RED_2"},
+        [LED_GREEN] = {.name = "LED_GREEN"},
+        {}
 };
 
 /*
- * Function: prob_device
- * ---------------------
- * Probe function for the platform driver. Called when a device is detected.
+ * Function: destroy_device_file
+ * -----------------------------
+ * devm action removing the device file created in probe.
+ */
+static void destroy_device_file(void *chardev)
+{
+    device_unregister(chardev);
+}
+
+/*
+ * Function: tera_led_drop
+ * -----------------------
+ * devm action dropping the reference of probe. Added first, so it runs
+ * after the LED class device and the device file are gone.
+ */
+static void tera_led_drop(void *led)
+{
+    tera_led_put(led);
+}
+
+/*
+ * Function: tera_probe_led
+ * ------------------------
+ * Sets up one LED for prob_device. Every resource is device managed, so a
+ * failed probe (for example -EPROBE_DEFER while the GPIO controller is not
+ * registered yet) and remove release them without extra code.
  * 
  * Parameters:
  * - sLED_P: Pointer to the platform device structure representing the detected device.
@@ -73,102 +125,127 @@ static struct platform_device_id device_id[] =
  * Returns:
  * - 0 on success, otherwise an error code.
  */
-int prob_device(struct platform_device *sLED_P)
+static int tera_probe_led(struct platform_device *sLED_P)
 {
+    struct device *dev = &sLED_P->dev;
+    int gpio = gpio_base + sLED_P->id;
+    struct device *chardev;
+    struct tera_led *led;
+    int ret;
+
     /*
      * Print a message indicating the detection of the device.
      */
-    printk("%s device_detected", sLED_P->name);
+    dev_dbg(dev, "%s device_detected\n", sLED_P->name);
 
     /*
-     * Check the name of the detected device and perform corresponding actions.
+     * The platform device id is the minor number of the device file.
      */
-    if (strcmp(sLED_P->name, "LED_RED") == 0)
+    if (sLED_P->id < 0 || sLED_P->id >= TERA_GPIO_MAX_PINS)
     {
-        /*
-         * Attempt to request GPIO pin 2 for the LED_RED device.
-         */
-        if (gpio_request(2, "LED_RED_pin"))
-        {
-            printk("Cannot allocate GPIO pin 2\n");
-        }
-        else
-        {
-            printk("GPIO pin 2 allocated successfully\n");
-        }
+        return dev_err_probe(dev, -EINVAL, "Invalid minor number %d\n", sLED_P->id);
+    }
 
-        /*
-         * Set GPIO pin 2 to be an output pin for the LED_RED device.
-         */
-        if (gpio_direction_output(2, 0))
-        {
-            printk("Cannot set the GPIO pin 2 to be output\n");
-            gpio_free(2);
-        }
-        else
-        {
-            printk("GPIO pin 2 set to be output\n");
-        }
+    /*
+     * The state of the LED, reference counted because open device files
+     * keep using it after remove.
+     */
+    led = kzalloc(sizeof(*led), GFP_KERNEL);
+    if (led == NULL)
+    {
+        return -ENOMEM;
     }
-    else if (strcmp(sLED_P->name, "LED_RED_2") == 0)
+    kref_init(&led->ref);
+    led->pin = sLED_P->id;
+    led->gpio = gpio;
+    ret = tera_stats_init(&led->stats);
+    if (ret)
     {
-        /*
-         * Attempt to request GPIO pin 3 for the LED_RED_2 device.
-         */
-        if (gpio_request(3, "LED_RED_2_pin"))
-        {
-            printk("Cannot allocate GPIO pin 3\n");
-        }
-
-        /*
-         * Set GPIO pin 3 to be an output pin for the LED_RED_2 device.
-         */
-        if (gpio_direction_output(3, 0))
-        {
-            printk("Cannot set the GPIO pin 3 to be output\n");
-            gpio_free(3);
-        }
+        kfree(led);
+        return dev_err_probe(dev, ret, "Statistics can not be allocated!\n");
     }
-    else if (strcmp(sLED_P->name, "LED_GREEN") == 0)
+    ret = devm_add_action_or_reset(dev, tera_led_drop, led);
+    if (ret)
     {
-        /*
-         * Attempt to request GPIO pin 4 for the LED_GREEN device.
-         */
-        if (gpio_request(4, "LED_GREEN_pin"))
-        {
-            printk("Cannot allocate GPIO pin 4\n");
-        }
+        return ret;
+    }
 
-        /*
-         * Set GPIO pin 4 to be an output pin for the LED_GREEN device.
-         */
-        if (gpio_direction_output(4, 0))
-        {
-            printk("Cannot set the GPIO pin 4 to be output\n");
-            gpio_free(4);
-        }
+    /*
+     * Request the GPIO pin as a low output. When the controller is not
+     * there yet this returns -EPROBE_DEFER and the probe is retried later.
+     */
+    ret = devm_gpio_request_one(dev, gpio, GPIOF_OUT_INIT_LOW, sLED_P->name);
+    if (ret)
+    {
+        return dev_err_probe(dev, ret, "Cannot allocate GPIO pin %d\n", gpio);
     }
+    led->desc = gpio_to_desc(gpio);
 
     /*
      * Create a device file for the detected device.
      */
-    if (device_create(teraData_st.my_class, NULL, teraData_st.my_device_nr + (sLED_P->id), NULL, sLED_P->name) == NULL)
+    chardev = device_create(teraData_st.my_class, dev, teraData_st.my_device_nr + sLED_P->id, NULL, sLED_P->name);
+    if (IS_ERR(chardev))
     {
-        printk("Can not create device file!\n");
+        return dev_err_probe(dev, PTR_ERR(chardev), "Can not create device file!\n");
     }
-    else
+    ret = devm_add_action_or_reset(dev, destroy_device_file, chardev);
+    if (ret)
+    {
+        return ret;
+    }
+
+    /*
+     * Let the in-kernel LED triggers drive the LED too.
+     */
+    ret = tera_led_register(sLED_P, led);
+    if (ret)
     {
-        printk("Device file Created!\n");
+        return dev_err_probe(dev, ret, "Can not register the LED class device!\n");
     }
 
+    /*
+     * Publish the counters and latency histograms of the LED.
+     */
+    tera_stats_debugfs(&led->stats, tera_debugfs, sLED_P->name);
+    platform_set_drvdata(sLED_P, led);
+
+    /*
+     * Publish the LED last, so opens and the command queue only see it
+     * complete.
+     */
+    rcu_assign_pointer(tera_leds[led->pin], led);
+
     return 0;
 }
 
+/*
+ * Function: prob_device
+ * ---------------------
+ * Probe function for the platform driver. Called when a device is detected,
+ * reports the probe time through the tera_probe tracepoint.
+ *
+ * Parameters:
+ * - sLED_P: Pointer to the platform device structure representing the detected device.
+ *
+ * Returns:
+ * - 0 on success, otherwise an error code.
+ */
+int prob_device(struct platform_device *sLED_P)
+{
+    u64 start = tera_stats_start();
+    int ret = tera_probe_led(sLED_P);
+
+    trace_tera_probe(sLED_P->name, sLED_P->id, ret, tera_stats_start() - start);
+    return ret;
+}
+
 
 /*
  * Function: device_remove
  * ------------------------
- * Function called when removing a platform device.
+ * Function called when removing a platform device. The GPIO pin and the
+ * device file are released by devm after this returns.
  * 
  * Parameters:
  * - sLED_P: Pointer to the platform device structure representing the device to be removed.
@@ -178,43 +255,22 @@ int prob_device(struct platform_device *sLED_P)
  */
 int device_remove(struct platform_device *sLED_P)
 {
-    /*
-     * Check the name of the device and perform corresponding cleanup actions.
-     */
-    if (strcmp(sLED_P->name, "LED_RED") == 0)
-    {
-        /*
-         * Set GPIO pin 2 to 0 and release it.
-         */
-        gpio_set_value(2, 0);
-        gpio_free(2);
-    }
-    else if (strcmp(sLED_P->name, "LED_RED_2") == 0)
-    {
-        /*
-         * Set GPIO pin 3 to 0 and release it.
-         */
-        gpio_set_value(3, 0);
-        gpio_free(3);
-    }
-    else if (strcmp(sLED_P->name, "LED_GREEN") == 0)
-    {
-        /*
-         * Set GPIO pin 4 to 0 and release it.
-         */
-        gpio_set_value(4, 0);
-        gpio_free(4);
-    }
+    struct tera_led *led = platform_get_drvdata(sLED_P);
 
     /*
-     * Destroy the device file associated with the device.
+     * Take the pin out of the command queue before it goes away, the
+     * timed writes of the other LEDs keep running. Then wait for the
+     * writes already handed to the workers.
      */
-    device_destroy(teraData_st.my_class, teraData_st.my_device_nr + (sLED_P->id));
+    gpio_queue_remove_pin(led->pin);
+    gpio_rt_sync();
+    gpio_flush_sync();
+    tera_stats_debugfs_remove(&led->stats);
 
     /*
-     * Print a message indicating that the device removal function was called.
+     * Turn the LED off before the pin is released.
      */
-    printk("device_remove");
+    gpiod_set_raw_value_cansleep(led->desc, 0);
 
     return 0;
 }
@@ -230,7 +286,9 @@ struct platform_driver platform_driver_data =
         .remove = device_remove,
         .id_table = device_id,
         .driver = {
-            .name = "mydriver"
+            .name = "mydriver",
+            .probe_type = PROBE_PREFER_ASYNCHRONOUS,
+            .groups = gpio_rt_groups // rt_enable, rt_cpu, rt_priority, rt_latency
         }
 };
 
@@ -243,11 +301,14 @@ static int __init teraINIT(void)
 {
     printk("PLatform driver inserted\n");
 
+    // The counters of the LEDs are allocated in probe and live below this directory
+    tera_debugfs = tera_stats_module_dir(KBUILD_MODNAME);
+
     // Allocate character device region
     if (alloc_chrdev_region(&teraData_st.my_device_nr, 0, 3, DRIVER_NAME) < 0)
     {
         printk("Device Nr. could not be allocated!\n");
-        return -1;
+        goto RegionError;
     }
 
     // Initialize the character device
@@ -266,12 +327,41 @@ static int __init teraINIT(void)
         goto ClassError;
     }
 
+    // Start the worker that writes sleeping GPIO controllers
+    if (gpio_flush_init())
+    {
+        printk("Flush workqueue can not be created!\n");
+        goto FlushError;
+    }
+
+    // Prepare the timed command queue
+    gpio_queue_init();
+
+    // Prepare the realtime worker, started from sysfs
+    gpio_rt_init();
+
     // Register platform driver
-    platform_driver_register(&platform_driver_data);
+    if (!probe_async)
+    {
+        platform_driver_data.driver.probe_type = PROBE_FORCE_SYNCHRONOUS;
+    }
+    if (platform_driver_register(&platform_driver_data))
+    {
+        printk("Platform driver can not be registered!\n");
+        goto DriverError;
+    }
     return 0;
 
+DriverError:
+    gpio_queue_exit();
+    gpio_rt_exit();
+    gpio_flush_exit();
+FlushError:
+    class_destroy(teraData_st.my_class);
 ClassError:
     unregister_chrdev_region(teraData_st.my_device_nr, 1);
+RegionError:
+    debugfs_remove(tera_debugfs);
     return -1;
 }
 
@@ -291,6 +381,21 @@ static void __exit teraDEINIT(void)
      */
     platform_driver_unregister(&platform_driver_data);
 
+    /*
+     * Stop the timed command queue.
+     */
+    gpio_queue_exit();
+
+    /*
+     * Apply the updates queued for the realtime worker and stop it.
+     */
+    gpio_rt_exit();
+
+    /*
+     * Apply the last coalesced writes and stop the flush worker.
+     */
+    gpio_flush_exit();
+
     /*
      * Destroy the device class.
      */
@@ -306,6 +411,16 @@ static void __exit teraDEINIT(void)
      */
     unregister_chrdev_region(teraData_st.my_device_nr, 1);
 
+    /*
+     * Remove the debugfs directory, the counters went away with their LEDs.
+     */
+    debugfs_remove(tera_debugfs);
+
+    /*
+     * Wait for the LEDs still being freed by RCU, the callback is module code.
+     */
+    rcu_barrier();
+
     /*
      * Print a goodbye message.
      */
@@ -0,0 +1,151 @@
+/*
+ * Author: Eng. Mostafa Tera
+ * Date: 19/10/2026
+ */
+
+#ifndef TERA_GPIO_UAPI
+#define TERA_GPIO_UAPI
+
+/*
+ * This header is shared between the driver and user space programs, so it
+ * only depends on the exported kernel headers.
+ */
+#include <linux/types.h>
+#include <linux/ioctl.h>
+
+/*
+ * Pin masks address the LED devices by minor number:
+ * bit 0 = LED_RED, bit 1 = LED_RED_2, bit 2 = LED_GREEN.
+ */
+#define TERA_GPIO_MAX_PINS 3
+#define TERA_GPIO_MASK_ALL ((1U << TERA_GPIO_MAX_PINS) - 1)
+
+/*
+ * Struct: tera_gpio_cmd
+ * ---------------------
+ * One scheduled bank write: at time_ns (CLOCK_MONOTONIC, nanoseconds) every
+ * pin set in mask is driven to the matching bit of value.
+ * Inside a pattern, time_ns is the offset from the start of the period.
+ */
+struct tera_gpio_cmd
+{
+    __s64 time_ns;
+    __u32 mask;
+    __u32 value;
+};
+
+/*
+ * Struct: tera_gpio_batch
+ * -----------------------
+ * A batch of commands sorted by time, appended to the driver queue.
+ */
+struct tera_gpio_batch
+{
+    __u32 count; /* Number of entries in cmds */
+    __u32 flags; /* Must be zero */
+    __u64 cmds;  /* User pointer to struct tera_gpio_cmd[count] */
+};
+
+/*
+ * Struct: tera_gpio_pattern
+ * -------------------------
+ * A repeating sequence: the steps are replayed every period_ns starting at
+ * start_ns, repeat times (0 = until cancelled).
+ */
+struct tera_gpio_pattern
+{
+    __s64 start_ns;
+    __u64 period_ns;
+    __u32 count;  /* Number of steps */
+    __u32 repeat; /* Number of periods, 0 = forever */
+    __u64 steps;  /* User pointer to struct tera_gpio_cmd[count] */
+};
+
+/*
+ * Struct: tera_gpio_queue_stats
+ * -----------------------------
+ * Timing statistics of the command queue since the last reset.
+ */
+struct tera_gpio_queue_stats
+{
+    __u64 applied;       /* Commands written to the pins */
+    __u64 overruns;      /* Commands applied later than the overrun threshold */
+    __u64 dropped;       /* Commands rejected because the queue was full */
+    __u64 max_late_ns;   /* Worst lateness seen */
+    __u64 total_late_ns; /* Sum of lateness, divide by applied for the mean */
+    __u32 pending;       /* Commands still waiting in the queue */
+    __u32 pattern;       /* 1 while a pattern is running */
+};
+
+/*
+ * Write protocols of an opened LED file, selected with TERA_GPIO_IOC_SET_MODE.
+ * TEXT: every '0' or '1' in the buffer clears or sets the LED.
+ * BINARY: the buffer is an array of struct tera_gpio_op.
+ */
+#define TERA_GPIO_MODE_TEXT 0
+#define TERA_GPIO_MODE_BINARY 1
+
+/*
+ * Operations of the binary protocol.
+ */
+#define TERA_GPIO_OP_PIN 1    /* Drive pin to value */
+#define TERA_GPIO_OP_MASK 2   /* Drive the pins in mask to the bits of value */
+#define TERA_GPIO_OP_TOGGLE 3 /* Invert the pins in mask */
+
+/*
+ * Struct: tera_gpio_op
+ * --------------------
+ * One command of the binary write protocol. The length of a binary write
+ * must be a multiple of this structure.
+ */
+struct tera_gpio_op
+{
+    __u8 op;        /* TERA_GPIO_OP_* */
+    __u8 pin;       /* Minor number for TERA_GPIO_OP_PIN */
+    __u16 reserved; /* Must be 0 */
+    __u32 mask;     /* Pins for TERA_GPIO_OP_MASK and TERA_GPIO_OP_TOGGLE */
+    __u32 value;    /* Level for TERA_GPIO_OP_PIN, levels for TERA_GPIO_OP_MASK */
+};
+
+/*
+ * Struct: tera_gpio_levels
+ * ------------------------
+ * Levels of a set of pins, used by the get/set/toggle ioctls.
+ */
+struct tera_gpio_levels
+{
+    __u32 mask;
+    __u32 value;
+};
+
+#define TERA_GPIO_IOC_MAGIC 't'
+
+/* Append a batch of timed commands to the queue */
+#define TERA_GPIO_IOC_QUEUE_SUBMIT _IOW(TERA_GPIO_IOC_MAGIC, 0x10, struct tera_gpio_batch)
+
+/* Replace the queue content with a repeating pattern */
+#define TERA_GPIO_IOC_QUEUE_PATTERN _IOW(TERA_GPIO_IOC_MAGIC, 0x11, struct tera_gpio_pattern)
+
+/* Drop every pending command and stop a running pattern */
+#define TERA_GPIO_IOC_QUEUE_CANCEL _IO(TERA_GPIO_IOC_MAGIC, 0x12)
+
+/* Read the statistics, the _RESET variant also clears them */
+#define TERA_GPIO_IOC_QUEUE_STATS _IOR(TERA_GPIO_IOC_MAGIC, 0x13, struct tera_gpio_queue_stats)
+#define TERA_GPIO_IOC_QUEUE_STATS_RESET _IOR(TERA_GPIO_IOC_MAGIC, 0x14, struct tera_gpio_queue_stats)
+
+/* Wait until every write queued for a sleeping GPIO controller is applied, like fsync() */
+#define TERA_GPIO_IOC_FLUSH _IO(TERA_GPIO_IOC_MAGIC, 0x20)
+
+/* Select the write protocol of this file, argument is a __u32 TERA_GPIO_MODE_* */
+#define TERA_GPIO_IOC_SET_MODE _IOW(TERA_GPIO_IOC_MAGIC, 0x30, __u32)
+
+/* Read the levels of every probed pin, mask returns which pins are valid */
+#define TERA_GPIO_IOC_GET _IOR(TERA_GPIO_IOC_MAGIC, 0x31, struct tera_gpio_levels)
+
+/* Drive the pins in mask to the bits of value */
+#define TERA_GPIO_IOC_SET _IOW(TERA_GPIO_IOC_MAGIC, 0x32, struct tera_gpio_levels)
+
+/* Invert the pins in mask, value is ignored */
+#define TERA_GPIO_IOC_TOGGLE _IOW(TERA_GPIO_IOC_MAGIC, 0x33, struct tera_gpio_levels)
+
+#endif // !TERA_GPIO_UAPI
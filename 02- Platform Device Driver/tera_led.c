@@ -0,0 +1,48 @@
+/*
+ * Author: Eng. Mostafa Tera
+ * Date: 19/10/2026
+ */
+
+#include "file_operations.h"
+#include "tera_led.h"
+
+/*
+ * Function: tera_led_set
+ * ----------------------
+ * brightness_set_blocking callback. Goes through tera_gpio_write like the
+ * device file, so the realtime and flush workers keep the writes in order.
+ */
+static int tera_led_set(struct led_classdev *cdev, enum led_brightness brightness)
+{
+    struct tera_led *led = container_of(cdev, struct tera_led, cdev);
+
+    tera_gpio_write(led->pin, brightness != LED_OFF);
+    return 0;
+}
+
+/*
+ * Function: tera_led_get
+ * ----------------------
+ * brightness_get callback.
+ */
+static enum led_brightness tera_led_get(struct led_classdev *cdev)
+{
+    struct tera_led *led = container_of(cdev, struct tera_led, cdev);
+    u32 value;
+
+    if (tera_gpio_bank_read(BIT(led->pin), &value))
+    {
+        return LED_OFF;
+    }
+    return value ? LED_ON : LED_OFF;
+}
+
+int tera_led_register(struct platform_device *sLED_P, struct tera_led *led)
+{
+    led->cdev.name = sLED_P->name;
+    led->cdev.max_brightness = LED_ON;
+    led->cdev.brightness_set_blocking = tera_led_set;
+    led->cdev.brightness_get = tera_led_get;
+
+    return devm_led_classdev_register(&sLED_P->dev, &led->cdev);
+}
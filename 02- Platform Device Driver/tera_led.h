@@ -0,0 +1,30 @@
+/*
+ * Author: Eng. Mostafa Tera
+ * Date: 19/10/2026
+ */
+
+#ifndef TERA_LED
+#define TERA_LED
+
+#include <linux/leds.h>
+
+struct tera_led;
+
+/*
+ * Function: tera_led_register
+ * ---------------------------
+ * Registers a LED with the LED class, so in-kernel triggers (timer,
+ * heartbeat, netdev, disk-activity) can drive it without user space.
+ * The class device is device managed and goes away with the device.
+ *
+ * Parameters:
+ * - sLED_P: The probed platform device, its name names the LED in
+ *   /sys/class/leds.
+ * - led: State of the LED, holds the class device.
+ *
+ * Returns:
+ * - 0 on success, otherwise an error code.
+ */
+int tera_led_register(struct platform_device *sLED_P, struct tera_led *led);
+
+#endif // !TERA_LED
@@ -3,25 +3,71 @@
  * Date: 29/4/2024
  */
 
+#include <linux/slab.h>
 #include "file_operations.h"
 
-static char RED_1[3] = {0};
-static char RED_2[3] = {0};
-static char GREEN[3] = {0};
+struct tera_node *tera_nodes[TERA_MAX_NODES];
 
-int global_minor;
+DEFINE_MUTEX(tera_nodes_lock);
 
-/*
- * Enum: devices
- * -------------
- * Enumerates the devices.
- */
-enum devices
+void tera_node_release(struct kref *ref)
+{
+    struct tera_node *node = container_of(ref, struct tera_node, ref);
+
+    tera_stats_exit(&node->stats);
+    sysfs_put(node->value_kn); // Notifiers are gone, open files held their reference until now
+    sysfs_put(node->direction_kn);
+    kfree(node);
+}
+
+int tera_node_level(struct tera_node *node, int *direction)
+{
+    int level;
+
+    tera_node_state(node, direction, &level);
+    if (*direction == TERA_GPIO_DIR_INPUT)
+    {
+        level = gpiod_get_value_cansleep(node->desc);
+    }
+    return level;
+}
+
+int tera_node_set_direction(struct tera_node *node, int direction)
 {
-    RED_1_e = 2,
-    RED_2_e,
-    GREEN_e
-} status;
+    int ret;
+
+    mutex_lock(&node->lock);
+
+    if (node->removed)
+    {
+        ret = -ENODEV; // The node was unbound while the file was open
+    }
+    else if (direction == TERA_GPIO_DIR_OUTPUT)
+    {
+        int value = gpio_shadow_get(&tera_shadow, node); // Keep the current level
+        gpio_events_stop(&node->events); // Stop capturing edges
+        ret = gpio_shadow_direction_output(&tera_shadow, node, value > 0); // Publishes (output, level)
+    }
+    else
+    {
+        ret = gpio_shadow_direction_input(&tera_shadow, node); // Publishes (input, level)
+        if (ret == 0 && gpio_events_start(&node->events)) // Capture edges on the input
+        {
+            dev_warn(node->dev, "edge capture is not available for %s\n", node->label);
+        }
+    }
+
+    mutex_unlock(&node->lock);
+
+    // Wake up the pollers of the direction and value attributes
+    if (ret == 0)
+    {
+        tera_node_changed(node, true);
+    }
+    return ret;
+}
+
+struct gpio_shadow tera_shadow;
 
 /*
  * Function: driver_open
@@ -38,26 +84,55 @@ enum devices
 int driver_open(struct inode *device_file, struct file *instance)
 {
     /*
-     * Extract the major and minor numbers from the device identifier.
+     * Extract the minor number from the device identifier.
      */
-    dev_t dev_id = device_file->i_rdev;
-    int major = MAJOR(dev_id);
-    int minor = MINOR(dev_id);
+    unsigned int minor = MINOR(device_file->i_rdev);
+    struct tera_node *node = NULL;
+    struct tera_file *tf;
 
     /*
-     * Store the minor number in a global variable.
+     * Take a reference to the node, it stays valid until close even when
+     * the node is unbound meanwhile.
      */
-    global_minor = minor;
+    mutex_lock(&tera_nodes_lock);
+    if (minor < TERA_MAX_NODES && tera_nodes[minor])
+    {
+        node = tera_nodes[minor];
+        kref_get(&node->ref);
+    }
+    mutex_unlock(&tera_nodes_lock);
+
+    if (node == NULL)
+    {
+        return -ENODEV; // The node of this minor is not probed
+    }
 
     /*
-     * Associate the global minor number with the file instance.
+     * Only allow the access modes given by the perm property of the node.
      */
-    instance->private_data = &global_minor;
+    if (((instance->f_mode & FMODE_READ) && !(node->perm & TERA_PERM_READ)) ||
+        ((instance->f_mode & FMODE_WRITE) && !(node->perm & TERA_PERM_WRITE)))
+    {
+        tera_node_put(node);
+        return -EACCES;
+    }
 
     /*
-     * Print a message indicating the device file is opened.
+     * Associate the node with the file instance, reads start in
+     * TERA_GPIO_READ_AUTO mode.
      */
-    printk("Opened device with major number %d and minor number %d\n", major, minor);
+    tf = kzalloc(sizeof(*tf), GFP_KERNEL);
+    if (tf == NULL)
+    {
+        tera_node_put(node);
+        return -ENOMEM;
+    }
+    tf->node = node;
+    tf->read_mode = TERA_GPIO_READ_AUTO;
+    mutex_init(&tf->lock);
+    instance->private_data = tf;
+
+    trace_tera_open(device_file->i_rdev);
 
     return 0;
 }
@@ -66,11 +141,17 @@ int driver_open(struct inode *device_file, struct file *instance)
 /*
  * Function: driver_close
  * ----------------------
- * Called when the device file is closed.
+ * Called when the device file is closed, stops its sampler and drops the
+ * reference taken by open.
  */
 int driver_close(struct inode *device_file, struct file *instance)
 {
-    printk("close FUNCTION was called!\n");
+    struct tera_file *tf = instance->private_data;
+
+    trace_tera_close(device_file->i_rdev);
+    gpio_sampler_free(tf->sampler);
+    tera_node_put(tf->node);
+    kfree(tf);
 
     return 0;
 }
@@ -78,7 +159,9 @@ int driver_close(struct inode *device_file, struct file *instance)
 /*+
  * Function: driver_write
  * ----------------------
- * Called when data is written to a device file.
+ * Called when data is written to a device file. The data is kept in the
+ * buffer of the node, a write larger than its buff_size fails with ENOSPC
+ * and a write to a pin switched to input with EBUSY.
  * 
  * Parameters:
  * - File: Pointer to the file structure representing the device file.
@@ -91,70 +174,381 @@ int driver_close(struct inode *device_file, struct file *instance)
  */
 ssize_t driver_write(struct file *File, const char *user_buffer, size_t count, loff_t *offs)
 {
-    printk("Write function is entered\n");
-    char (*value)[3] = NULL;
-    int not_copied;
-    
-    /*
-     * Determine the device based on the minor number associated with the file.
-     */
-    if (*(int *)File->private_data == 0)
+    struct tera_node *node = ((struct tera_file *)File->private_data)->node;
+    u64 start = tera_stats_start(), ns;
+    ssize_t ret;
+
+    if (count > node->buff_size)
+    {
+        ret = -ENOSPC; // Does not fit the buffer of the node
+    }
+    else if (mutex_lock_interruptible(&node->lock))
     {
-        printk("The minor who called write is minor 0\n");
-        value = &RED_1;
-        status = RED_1_e;
+        ret = -ERESTARTSYS;
     }
-    else if (*(int *)File->private_data == 1)
+    else if (node->removed)
     {
-        printk("The minor who called write is minor 1\n");
-        value = &RED_2;
-        status = RED_2_e;
+        mutex_unlock(&node->lock);
+        ret = -ENODEV; // The node was unbound while the file was open
     }
-    else if (*(int *)File->private_data == 2)
+    else if (!tera_node_is_output(node))
     {
-        printk("The minor who called write is minor 2\n");
-        value = &GREEN;
-        status = GREEN_e;
+        mutex_unlock(&node->lock);
+        ret = -EBUSY; // The pin was switched to input
     }
+    else
+    {
+        /*
+         * Copy data from user space to the buffer of the node.
+         */
+        ret = count - copy_from_user(node->buffer, user_buffer, count);
+        node->buffer_len = ret;
 
-    /*
-     * Copy data from user space to kernel space.
-     */
-    not_copied = copy_from_user(value, user_buffer, sizeof(RED_1));
+        /*
+         * Process the data and perform corresponding actions.
+         */
+        switch (ret ? node->buffer[0] : 0)
+        {
+        case '0':
+            gpio_shadow_set(&tera_shadow, node, 0);
+            break;
+        case '1':
+            gpio_shadow_set(&tera_shadow, node, 1);
+            break;
+        default:
+            break; // Invalid input, ignored
+        }
+        mutex_unlock(&node->lock);
 
-    /*
-     * Process the data and perform corresponding actions.
-     */
-    switch ((*value)[0])
+        if (ret == 0 && count)
+        {
+            ret = -EFAULT; // Nothing could be copied
+        }
+    }
+
+    if (ret > 0)
+    {
+        tera_pmu_add(TERA_PMU_BYTES_WRITTEN, ret);
+    }
+    ns = tera_stats_op(&node->stats, TERA_PATH_WRITE, ret, count, start);
+    trace_tera_write(file_inode(File)->i_rdev, count, ret, ns);
+    return ret;
+}
+
+
+/*
+ * Function: tera_file_node_level
+ * ------------------------------
+ * tera_node_level for a file of the node. Outputs are answered from the
+ * seqlock snapshot without any lock, the pin is not touched. Inputs are
+ * read from the pin with node->lock held across the removed check and the
+ * GPIO access, so device_remove cannot release the pin in between.
+ *
+ * Returns:
+ * - The level, -ENODEV once the node was unbound, otherwise an error code.
+ */
+static int tera_file_node_level(struct tera_node *node, int *direction)
+{
+    int level;
+
+    tera_node_state(node, direction, &level);
+    if (*direction == TERA_GPIO_DIR_OUTPUT)
     {
-    case '0':
-        gpio_set_value(status, 0);
-        printk("gpio clear is done\n");
+        return READ_ONCE(node->removed) ? -ENODEV : level; // The file holds a reference, the node stays
+    }
+
+    if (mutex_lock_interruptible(&node->lock))
+    {
+        return -ERESTARTSYS;
+    }
+    if (node->removed)
+    {
+        level = -ENODEV; // The node was unbound while the file was open
+    }
+    else
+    {
+        level = tera_node_level(node, direction);
+    }
+    mutex_unlock(&node->lock);
+    return level;
+}
+
+/*
+ * Function: tera_file_read_level
+ * ------------------------------
+ * Returns the level of the pin as "0\n" or "1\n" at offset 0, so cat
+ * and pread() both work. Outputs come from the published state, inputs are
+ * sampled from the pin.
+ */
+static ssize_t tera_file_read_level(struct tera_node *node, char __user *user_buffer, size_t count, loff_t *offs)
+{
+    char text[2];
+    int direction, level;
+
+    level = tera_file_node_level(node, &direction);
+    if (level < 0)
+    {
+        return level;
+    }
+    text[0] = level ? '1' : '0';
+    text[1] = '\n';
+    return simple_read_from_buffer(user_buffer, count, offs, text, sizeof(text));
+}
+
+/*
+ * Function: tera_file_read_buffer
+ * -------------------------------
+ * Returns the bytes of the last write kept in the buffer of the node, from
+ * offset 0 like a regular file.
+ */
+static ssize_t tera_file_read_buffer(struct tera_node *node, char __user *user_buffer, size_t count, loff_t *offs)
+{
+    ssize_t ret;
+
+    if (mutex_lock_interruptible(&node->lock))
+    {
+        return -ERESTARTSYS;
+    }
+    ret = simple_read_from_buffer(user_buffer, count, offs, node->buffer, node->buffer_len);
+    mutex_unlock(&node->lock);
+    return ret;
+}
+
+/*
+ * Function: driver_read
+ * ---------------------
+ * Called when data is read from a device file. What is returned depends on
+ * the read mode of the file, see TERA_GPIO_IOC_SET_READ_MODE: the level of
+ * the pin, the edges captured on an input as struct tera_gpio_event,
+ * periodic samples as struct tera_gpio_sample, or the data of the last
+ * write. The default mode returns
+ * edges while the pin captures them or some are left unread, and the level
+ * otherwise.
+ *
+ * Parameters:
+ * - File: Pointer to the file structure representing the device file.
+ * - user_buffer: Buffer receiving the level or whole records.
+ * - count: Size of the buffer.
+ * - offs: Pointer to the current file position, used by the level mode.
+ *
+ * Returns:
+ * - Number of bytes read, or a negative error code on failure.
+ */
+ssize_t driver_read(struct file *File, char *user_buffer, size_t count, loff_t *offs)
+{
+    struct tera_file *tf = File->private_data;
+    struct tera_node *node = tf->node;
+    u64 start = tera_stats_start(), ns;
+    ssize_t ret;
+
+    switch (smp_load_acquire(&tf->read_mode))
+    {
+    case TERA_GPIO_READ_LEVEL:
+        ret = tera_file_read_level(node, user_buffer, count, offs);
+        break;
+    case TERA_GPIO_READ_EVENTS:
+        ret = gpio_events_read(&node->events, File, user_buffer, count);
+        break;
+    case TERA_GPIO_READ_SAMPLES:
+        ret = gpio_sampler_read(tf->sampler, File, user_buffer, count);
         break;
-    case '1':
-        gpio_set_value(status, 1);
-        printk("gpio set is done\n");
+    case TERA_GPIO_READ_BUFFER:
+        ret = tera_file_read_buffer(node, user_buffer, count, offs);
         break;
     default:
-        printk("gpio Invalid input\n");
+        if (READ_ONCE(node->events.irq) || gpio_events_pending(&node->events))
+        {
+            ret = gpio_events_read(&node->events, File, user_buffer, count);
+        }
+        else
+        {
+            ret = tera_file_read_level(node, user_buffer, count, offs);
+        }
         break;
     }
 
-    /*
-     * Adjust the count based on the bytes successfully written.
-     */
-    count = count - not_copied;
-    return count;
+    ns = tera_stats_op(&node->stats, TERA_PATH_READ, ret, count, start);
+    trace_tera_read(file_inode(File)->i_rdev, count, ret, ns);
+    return ret;
 }
 
+/*
+ * Function: driver_poll
+ * ---------------------
+ * Called when a device file is polled. Reports readable once an input pin
+ * captured an edge, or a sample was taken in TERA_GPIO_READ_SAMPLES mode.
+ * In TERA_GPIO_READ_LEVEL and TERA_GPIO_READ_BUFFER modes the file is always
+ * readable.
+ */
+__poll_t driver_poll(struct file *File, poll_table *wait)
+{
+    struct tera_file *tf = File->private_data;
+
+    switch (smp_load_acquire(&tf->read_mode))
+    {
+    case TERA_GPIO_READ_LEVEL:
+    case TERA_GPIO_READ_BUFFER:
+        return EPOLLIN | EPOLLRDNORM;
+    case TERA_GPIO_READ_SAMPLES:
+        return gpio_sampler_poll(tf->sampler, File, wait);
+    default:
+        return gpio_events_poll(&tf->node->events, File, wait);
+    }
+}
 
 /*
- * Function: driver_read
+ * Function: tera_file_set_read_mode
+ * ---------------------------------
+ * Handles TERA_GPIO_IOC_SET_READ_MODE. The sampler of the file is created
+ * on first use and kept until close, so readers never see it go away.
+ */
+static long tera_file_set_read_mode(struct tera_file *tf, const struct tera_gpio_read_mode *mode)
+{
+    int ret;
+
+    if (mode->mode > TERA_GPIO_READ_BUFFER)
+    {
+        return -EINVAL;
+    }
+    if (mode->mode == TERA_GPIO_READ_SAMPLES && mode->period_us < TERA_GPIO_SAMPLE_MIN_US)
+    {
+        return -EINVAL;
+    }
+
+    mutex_lock(&tf->lock);
+    if (mode->mode == TERA_GPIO_READ_SAMPLES)
+    {
+        if (tf->sampler == NULL)
+        {
+            tf->sampler = gpio_sampler_create(tf->node);
+            if (tf->sampler == NULL)
+            {
+                mutex_unlock(&tf->lock);
+                return -ENOMEM;
+            }
+        }
+        ret = gpio_sampler_start(tf->sampler, mode->period_us);
+        if (ret)
+        {
+            mutex_unlock(&tf->lock);
+            return ret;
+        }
+    }
+    else if (tf->sampler)
+    {
+        gpio_sampler_stop(tf->sampler);
+    }
+    smp_store_release(&tf->read_mode, mode->mode); // After the sampler, readers use it once they see the mode
+    mutex_unlock(&tf->lock);
+    return 0;
+}
+
+/*
+ * Function: tera_node_set_bank
+ * ----------------------------
+ * Drives the pins of a bank in bank->mask to their bit of bank->values,
+ * see TERA_GPIO_IOC_SET_BANK.
+ */
+static int tera_node_set_bank(struct tera_node *node, const struct tera_gpio_bank *bank)
+{
+    int ret;
+
+    mutex_lock(&node->lock);
+
+    if (node->removed)
+    {
+        ret = -ENODEV; // The node was unbound while the file was open
+    }
+    else if (!tera_node_is_output(node))
+    {
+        ret = -EBUSY; // The pin was switched to input
+    }
+    else
+    {
+        ret = gpio_shadow_set_bank(&tera_shadow, node, bank->mask, bank->values);
+    }
+
+    mutex_unlock(&node->lock);
+    return ret;
+}
+
+/*
+ * Function: driver_ioctl
+ * ----------------------
+ * Called for ioctl requests on a device file, so one file serves every
+ * access to its pin: direction changes, the (direction, level) pair, the
+ * read mode and the levels of the pins of a bank.
+ *
+ * Parameters:
+ * - File: Pointer to the file structure representing the device file.
+ * - cmd: ioctl request code.
+ * - arg: Request argument, a user pointer.
+ *
+ * Returns:
+ * - 0 on success, otherwise an error code.
+ */
+long driver_ioctl(struct file *File, unsigned int cmd, unsigned long arg)
+{
+    struct tera_file *tf = File->private_data;
+    struct tera_gpio_read_mode mode;
+    struct tera_gpio_state state;
+    struct tera_gpio_bank bank;
+    int direction, level;
+    u32 value;
+
+    switch (cmd)
+    {
+    case TERA_GPIO_IOC_SET_DIRECTION:
+        if (!(File->f_mode & FMODE_WRITE))
+        {
+            return -EBADF; // Changing the pin needs write access, like write()
+        }
+        if (get_user(value, (u32 __user *)arg))
+        {
+            return -EFAULT;
+        }
+        if (value != TERA_GPIO_DIR_INPUT && value != TERA_GPIO_DIR_OUTPUT)
+        {
+            return -EINVAL;
+        }
+        return tera_node_set_direction(tf->node, value);
+    case TERA_GPIO_IOC_GET_STATE:
+        level = tera_file_node_level(tf->node, &direction);
+        if (level < 0)
+        {
+            return level;
+        }
+        state.direction = direction;
+        state.level = level;
+        return copy_to_user((void __user *)arg, &state, sizeof(state)) ? -EFAULT : 0;
+    case TERA_GPIO_IOC_SET_READ_MODE:
+        if (copy_from_user(&mode, (void __user *)arg, sizeof(mode)))
+        {
+            return -EFAULT;
+        }
+        return tera_file_set_read_mode(tf, &mode);
+    case TERA_GPIO_IOC_SET_BANK:
+        if (!(File->f_mode & FMODE_WRITE))
+        {
+            return -EBADF;
+        }
+        if (copy_from_user(&bank, (void __user *)arg, sizeof(bank)))
+        {
+            return -EFAULT;
+        }
+        return tera_node_set_bank(tf->node, &bank);
+    default:
+        return -ENOTTY;
+    }
+}
+
+/*
+ * Function: driver_mmap
  * ---------------------
- * Called when data is read from a device file.
+ * Called when a device file is mapped. Every LED file maps the same
+ * read-only status page, see struct tera_gpio_status_page.
  */
-ssize_t driver_read(struct file *File, char *user_buffer, size_t count, loff_t *offs)
+int driver_mmap(struct file *File, struct vm_area_struct *vma)
 {
-    printk("read function is called but this pin is just output\n");
-    return -ENOSYS;
+    return gpio_status_mmap(File, vma);
 }
@@ -19,19 +19,227 @@
 #include <linux/of.h>
 #include <linux/gpio/consumer.h>
 #include <linux/property.h>
+#include <linux/idr.h>
+#include <linux/kref.h>
+#include <linux/seqlock.h>
+#include <linux/sysfs.h>
+#include <linux/kernfs.h>
+#include "gpio_events.h"
+#include "gpio_shadow.h"
+#include "gpio_status.h"
+#include "gpio_sampler.h"
+#include "../common/tera_stats.h"
+#include "../common/tera_trace.h"
+#include "../common/tera_pmu.h"
 
 /*
- * Enum: devices_name
- * -------------------
- * Enumerates the names of devices.
+ * TERA_MAX_NODES: Number of minor numbers served by the driver, every
+ * probed LED node takes one.
  */
-enum devices_name
+#define TERA_MAX_NODES TERA_SHADOW_PINS
+
+/*
+ * TERA_BANK_MAX_PINS: Largest number of GPIOs in the gpios property of a node.
+ */
+#define TERA_BANK_MAX_PINS 32
+
+/*
+ * TERA_BUFF_SIZE_MAX: Largest buff_size property, the data buffer of a node.
+ */
+#define TERA_BUFF_SIZE_MAX PAGE_SIZE
+
+/*
+ * Bits of the perm property: the high nibble allows reading the device file
+ * of the node, the low nibble writing it. 0x11 is read/write, 0x10 read only.
+ */
+#define TERA_PERM_READ 0x10
+#define TERA_PERM_WRITE 0x01
+
+/*
+ * Struct: tera_node
+ * -----------------
+ * State of one probed LED node. It is allocated in probe and kept in the
+ * drvdata of the platform device, so the sysfs attributes and the device
+ * file reach their pin directly, whatever the number of nodes. The cached
+ * output level lives in tera_shadow under the bit of index.
+ *
+ * A node whose gpios or gpio_pin property lists several pins is a bank:
+ * the pins are driven together and always hold the same level.
+ *
+ * The node is reference counted: probe holds one reference until unbind,
+ * every open file holds another, so a node removed by an overlay while its
+ * device file is open is freed on the last close.
+ */
+struct tera_node
+{
+    int index;                 /* Minor number, also the bit of the node in tera_shadow and the status page */
+    struct device *dev;        /* Platform device of the node, holds the sysfs attributes */
+    struct kref ref;           /* References of probe and of the open files */
+    bool removed;              /* Unbound, the pins are gone. Set under lock */
+    struct gpio_desc *desc;    /* First pin of the node */
+    struct gpio_descs *bank;   /* Every pin of a bank, NULL for single pin nodes */
+    unsigned int ngpios;       /* Number of pins, 1 unless the node is a bank */
+    const char *label;         /* DT label, name of the device file */
+    seqlock_t state;           /* Guards the (direction, level) pair, readers retry instead of blocking writers */
+    int direction;             /* TERA_GPIO_DIR_OUTPUT or TERA_GPIO_DIR_INPUT, written under state */
+    int level;                 /* Last level driven, or captured on an input, written under state */
+    atomic_t changes;          /* Level or direction changes, reported by the bulk state file */
+    struct mutex lock;         /* Serialises direction changes */
+    struct list_head samplers; /* Samplers of the open files, under lock */
+    struct gpio_events events; /* Edge capture state */
+    struct tera_stats stats;   /* Counters and latency histograms, in debugfs under tera/teraGPIO_dt/<label>/ */
+    struct kernfs_node *value_kn;     /* value attribute, looked up once in probe for tera_node_changed */
+    struct kernfs_node *direction_kn; /* direction attribute, likewise */
+    u32 perm;                  /* perm property, TERA_PERM_READ and TERA_PERM_WRITE */
+    u32 buff_size;             /* buff_size property, capacity of buffer */
+    size_t buffer_len;         /* Bytes of the last write held in buffer */
+    char buffer[];             /* Last write to the device file, allocated with the node */
+};
+
+/*
+ * Array: tera_nodes
+ * -----------------
+ * Probed LED nodes indexed by minor number, NULL while a minor is unbound.
+ * Used by open to hand the node to the other file operations. Probe and
+ * remove update it under tera_nodes_lock, walks over every node hold it.
+ */
+extern struct tera_node *tera_nodes[TERA_MAX_NODES];
+extern struct mutex tera_nodes_lock;
+
+/*
+ * Function: tera_node_release
+ * ---------------------------
+ * kref release of a node, frees its counters and the node itself.
+ */
+void tera_node_release(struct kref *ref);
+
+/*
+ * Function: tera_node_put
+ * -----------------------
+ * Drops a reference to a node.
+ */
+static inline void tera_node_put(struct tera_node *node)
+{
+    kref_put(&node->ref, tera_node_release);
+}
+
+/*
+ * Function: tera_node_changed
+ * ---------------------------
+ * Counts a level or direction change of a node and wakes up poll() and
+ * select() waiting with POLLPRI on its value attribute, and on direction
+ * as well when the direction changed. The attributes were looked up in
+ * probe, so this does not search the sysfs directory under its mutex on
+ * every write. Changes made by probe before the attributes exist notify
+ * nobody.
+ */
+static inline void tera_node_changed(struct tera_node *node, bool direction)
+{
+    atomic_inc(&node->changes);
+    if (node->value_kn)
+    {
+        kernfs_notify(node->value_kn);
+    }
+    if (direction && node->direction_kn)
+    {
+        kernfs_notify(node->direction_kn);
+    }
+}
+
+/*
+ * Function: tera_node_publish
+ * ---------------------------
+ * Stores a new (direction, level) pair of a node and mirrors it to the
+ * status page. Writers are serialised by the seqlock, readers never take it.
+ * The status page is updated inside the write section, so concurrent
+ * writers reach the page in the same order as the node.
+ */
+static inline void tera_node_publish(struct tera_node *node, int direction, int level)
+{
+    unsigned long flags;
+
+    write_seqlock_irqsave(&node->state, flags); // The samplers read the pair from hardirq context
+    node->direction = direction;
+    node->level = !!level;
+    gpio_status_update(node->index, node->level, direction);
+    write_sequnlock_irqrestore(&node->state, flags);
+}
+
+/*
+ * Function: tera_node_state
+ * -------------------------
+ * Reads the (direction, level) pair of a node without blocking, retrying
+ * while a writer is in the middle of an update.
+ */
+static inline void tera_node_state(struct tera_node *node, int *direction, int *level)
+{
+    unsigned int seq;
+
+    do
+    {
+        seq = read_seqbegin(&node->state);
+        *direction = node->direction;
+        *level = node->level;
+    } while (read_seqretry(&node->state, seq));
+}
+
+/*
+ * Function: tera_node_is_output
+ * -----------------------------
+ * Checks the published direction of a node without blocking.
+ */
+static inline bool tera_node_is_output(struct tera_node *node)
+{
+    int direction, level;
+
+    tera_node_state(node, &direction, &level);
+    return direction == TERA_GPIO_DIR_OUTPUT;
+}
+
+/*
+ * Function: tera_node_level
+ * -------------------------
+ * Returns the level of a node with its direction. Outputs come from the
+ * published state, inputs are sampled from the pin since their level is
+ * driven from outside.
+ *
+ * Returns:
+ * - 0 or 1, otherwise an error code.
+ */
+int tera_node_level(struct tera_node *node, int *direction);
+
+/*
+ * Function: tera_node_set_direction
+ * ---------------------------------
+ * Switches a node to TERA_GPIO_DIR_INPUT, capturing its edges, or to
+ * TERA_GPIO_DIR_OUTPUT at its current level. Used by the direction
+ * attribute and TERA_GPIO_IOC_SET_DIRECTION.
+ *
+ * Returns:
+ * - 0 on success, otherwise an error code.
+ */
+int tera_node_set_direction(struct tera_node *node, int direction);
+
+/*
+ * Struct: tera_file
+ * -----------------
+ * State of one opened device file.
+ */
+struct tera_file
 {
-    LED_RED,
-    LED_RED_2,
-    LED_GREEN
+    struct tera_node *node;       /* Node of the minor, referenced until close */
+    u32 read_mode;                /* TERA_GPIO_READ_*, published with release after sampler */
+    struct gpio_sampler *sampler; /* Created by the first TERA_GPIO_READ_SAMPLES, freed on close */
+    struct mutex lock;            /* Serialises read mode changes */
 };
 
+/*
+ * Variable: tera_shadow
+ * ---------------------
+ * Shadow cache of the output levels, indexed by minor number.
+ */
+extern struct gpio_shadow tera_shadow;
+
 /*
  * Function: driver_open
  * ---------------------
@@ -60,4 +268,25 @@ ssize_t driver_write(struct file *File, const char *user_buffer, size_t count, l
  */
 ssize_t driver_read(struct file *File,char *user_buffer, size_t count, loff_t *offs);
 
+/*
+ * Function: driver_poll
+ * ---------------------
+ * Called when a device file is polled.
+ */
+__poll_t driver_poll(struct file *File, poll_table *wait);
+
+/*
+ * Function: driver_ioctl
+ * ----------------------
+ * Called for ioctl requests on a device file.
+ */
+long driver_ioctl(struct file *File, unsigned int cmd, unsigned long arg);
+
+/*
+ * Function: driver_mmap
+ * ---------------------
+ * Called when a device file is mapped.
+ */
+int driver_mmap(struct file *File, struct vm_area_struct *vma);
+
 #endif // !FILE_OPERATION
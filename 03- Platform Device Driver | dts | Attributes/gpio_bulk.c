@@ -0,0 +1,118 @@
+/*
+ * Author: Eng. Mostafa Tera
+ * Date: 19/10/2026
+ */
+
+#include <linux/bitmap.h>
+#include <linux/slab.h>
+#include "file_operations.h"
+#include "gpio_bulk.h"
+
+/*
+ * Function: state_read
+ * --------------------
+ * Builds a snapshot of every probed node, so a whole board is read with
+ * one read() instead of a direction and a value read per node.
+ */
+static ssize_t state_read(struct file *filp, struct kobject *kobj, struct bin_attribute *attr,
+                          char *buf, loff_t off, size_t count)
+{
+    DECLARE_BITMAP(present, TERA_GPIO_BULK_MAX_PINS);
+    DECLARE_BITMAP(directions, TERA_GPIO_BULK_MAX_PINS);
+    DECLARE_BITMAP(levels, TERA_GPIO_BULK_MAX_PINS);
+    struct tera_gpio_bulk_state *state;
+    int i, direction;
+    ssize_t ret;
+
+    BUILD_BUG_ON(TERA_MAX_NODES > TERA_GPIO_BULK_MAX_PINS);
+
+    state = kzalloc(sizeof(*state), GFP_KERNEL);
+    if (state == NULL)
+    {
+        return -ENOMEM;
+    }
+    bitmap_zero(present, TERA_GPIO_BULK_MAX_PINS);
+    bitmap_zero(directions, TERA_GPIO_BULK_MAX_PINS);
+    bitmap_zero(levels, TERA_GPIO_BULK_MAX_PINS);
+
+    mutex_lock(&tera_nodes_lock);
+    for (i = 0; i < TERA_MAX_NODES; i++)
+    {
+        struct tera_node *node = tera_nodes[i];
+
+        if (node == NULL)
+        {
+            continue;
+        }
+        __set_bit(i, present);
+        __assign_bit(i, levels, tera_node_level(node, &direction) > 0); // A consistent pair per node
+        __assign_bit(i, directions, direction == TERA_GPIO_DIR_OUTPUT);
+        state->changes[i] = atomic_read(&node->changes);
+    }
+    mutex_unlock(&tera_nodes_lock);
+
+    state->npins = TERA_MAX_NODES;
+    bitmap_to_arr64(state->present, present, TERA_GPIO_BULK_MAX_PINS);
+    bitmap_to_arr64(state->directions, directions, TERA_GPIO_BULK_MAX_PINS);
+    bitmap_to_arr64(state->levels, levels, TERA_GPIO_BULK_MAX_PINS);
+
+    ret = memory_read_from_buffer(buf, count, &off, state, sizeof(*state));
+    kfree(state);
+    return ret;
+}
+
+/*
+ * Function: state_write
+ * ---------------------
+ * Applies a masked update to every node in one write(). The mask is checked
+ * first, so a bad update changes nothing.
+ */
+static ssize_t state_write(struct file *filp, struct kobject *kobj, struct bin_attribute *attr,
+                           char *buf, loff_t off, size_t count)
+{
+    struct tera_gpio_bulk_update *update = (struct tera_gpio_bulk_update *)buf;
+    DECLARE_BITMAP(mask, TERA_GPIO_BULK_MAX_PINS);
+    DECLARE_BITMAP(levels, TERA_GPIO_BULK_MAX_PINS);
+    ssize_t ret = count;
+    int i;
+
+    if (off != 0 || count != sizeof(*update))
+    {
+        return -EINVAL;
+    }
+    bitmap_from_arr64(mask, update->mask, TERA_GPIO_BULK_MAX_PINS);
+    bitmap_from_arr64(levels, update->levels, TERA_GPIO_BULK_MAX_PINS);
+
+    mutex_lock(&tera_nodes_lock);
+    for_each_set_bit(i, mask, TERA_GPIO_BULK_MAX_PINS)
+    {
+        if (i >= TERA_MAX_NODES || tera_nodes[i] == NULL || !gpio_shadow_is_output(&tera_shadow, i))
+        {
+            ret = -EINVAL; // Only probed outputs can be driven
+            goto out;
+        }
+    }
+    for_each_set_bit(i, mask, TERA_GPIO_BULK_MAX_PINS)
+    {
+        gpio_shadow_set(&tera_shadow, tera_nodes[i], test_bit(i, levels));
+    }
+out:
+    mutex_unlock(&tera_nodes_lock);
+    return ret;
+}
+
+static BIN_ATTR_RW(state, sizeof(struct tera_gpio_bulk_state));
+
+static struct bin_attribute *gpio_bulk_bin_attrs[] = {
+    &bin_attr_state,
+    NULL,
+};
+
+static const struct attribute_group gpio_bulk_group = {
+    .bin_attrs = gpio_bulk_bin_attrs,
+};
+
+const struct attribute_group *gpio_bulk_groups[] = {
+    &gpio_bulk_group,
+    NULL,
+};
@@ -0,0 +1,20 @@
+/*
+ * Author: Eng. Mostafa Tera
+ * Date: 19/10/2026
+ */
+
+#ifndef GPIO_BULK
+#define GPIO_BULK
+
+#include <linux/sysfs.h>
+
+/*
+ * Array: gpio_bulk_groups
+ * -----------------------
+ * Driver attributes reading and writing every node in one call: the binary
+ * state file, see struct tera_gpio_bulk_state and struct
+ * tera_gpio_bulk_update.
+ */
+extern const struct attribute_group *gpio_bulk_groups[];
+
+#endif // !GPIO_BULK
@@ -0,0 +1,318 @@
+/*
+ * Author: Eng. Mostafa Tera
+ * Date: 19/10/2026
+ */
+
+#include <linux/interrupt.h>
+#include "file_operations.h"
+#include "gpio_events.h"
+#include "gpio_status.h"
+
+/*
+ * Function: gpio_events_push
+ * --------------------------
+ * Appends one event to the ring, dropping it when readers did not keep up.
+ * Only one context pushes at a time: the interrupt thread, or the debounce
+ * work when the software filter is active.
+ */
+static void gpio_events_push(struct gpio_events *events, u64 timestamp, int level)
+{
+    struct tera_node *node = container_of(events, struct tera_node, events);
+    unsigned int head = events->head;
+    unsigned int tail = smp_load_acquire(&events->tail);
+    struct tera_gpio_event *event;
+
+    events->level = level;
+    tera_node_publish(node, TERA_GPIO_DIR_INPUT, level);
+    tera_node_changed(node, false);
+
+    if (head - tail >= GPIO_EVENTS_RING_SIZE)
+    {
+        events->seqno++;
+        events->dropped++;
+        tera_stats_add(&container_of(events, struct tera_node, events)->stats, TERA_PATH_READ, TERA_STAT_DROPS, 1);
+        tera_pmu_add(TERA_PMU_BUFFER_FULL, 1);
+        return;
+    }
+
+    event = &events->ring[head & (GPIO_EVENTS_RING_SIZE - 1)];
+    event->timestamp_ns = timestamp;
+    event->seqno = events->seqno++;
+    event->level = level;
+    event->edge = level ? TERA_GPIO_EDGE_RISING : TERA_GPIO_EDGE_FALLING;
+    event->reserved = 0;
+
+    /* Publish the record before the new head */
+    smp_store_release(&events->head, head + 1);
+    if (wq_has_sleeper(&events->wait))
+    {
+        tera_pmu_add(TERA_PMU_READ_WAKEUPS, 1);
+    }
+    wake_up_interruptible_poll(&events->wait, EPOLLIN | EPOLLRDNORM);
+}
+
+/*
+ * Function: gpio_events_hardirq
+ * -----------------------------
+ * Hard interrupt handler. Only takes the time stamp, so it is as close to
+ * the edge as possible, and defers the rest to the interrupt thread.
+ * IRQF_ONESHOT keeps the line masked until the thread consumed it.
+ */
+static irqreturn_t gpio_events_hardirq(int irq, void *data)
+{
+    struct gpio_events *events = data;
+
+    events->irq_timestamp = ktime_get_ns();
+    return IRQ_WAKE_THREAD;
+}
+
+/*
+ * Function: gpio_events_thread
+ * ----------------------------
+ * Threaded interrupt handler. Without a software filter the edge is
+ * delivered right away, otherwise the debounce work is pushed back until
+ * the pin stays quiet for debounce_us.
+ */
+static irqreturn_t gpio_events_thread(int irq, void *data)
+{
+    struct gpio_events *events = data;
+    int level;
+
+    if (events->debounce_us && !events->hw_debounce)
+    {
+        WRITE_ONCE(events->pending_timestamp, events->irq_timestamp);
+        if (mod_delayed_work(system_highpri_wq, &events->debounce_work,
+                             usecs_to_jiffies(events->debounce_us)))
+        {
+            atomic_long_inc(&events->suppressed); // The previous edge did not settle
+        }
+        return IRQ_HANDLED;
+    }
+
+    level = gpiod_get_value_cansleep(events->desc) ? 1 : 0;
+
+    /* A hardware filtered line only reports settled levels, skip repeats */
+    if (events->hw_debounce && level == events->level)
+    {
+        atomic_long_inc(&events->suppressed);
+        return IRQ_HANDLED;
+    }
+
+    gpio_events_push(events, events->irq_timestamp, level);
+    return IRQ_HANDLED;
+}
+
+/*
+ * Function: gpio_events_debounce_fn
+ * ---------------------------------
+ * Software filter. Runs once no edge was seen for debounce_us and delivers
+ * the settled level, unless the burst was a glitch that ended where it began.
+ */
+static void gpio_events_debounce_fn(struct work_struct *work)
+{
+    struct gpio_events *events = container_of(to_delayed_work(work), struct gpio_events, debounce_work);
+    int level = gpiod_get_value_cansleep(events->desc) ? 1 : 0;
+
+    if (level == events->level)
+    {
+        atomic_long_inc(&events->suppressed);
+        return;
+    }
+    gpio_events_push(events, READ_ONCE(events->pending_timestamp), level);
+}
+
+void gpio_events_setup(struct gpio_events *events, int index, struct gpio_desc *desc, const char *label)
+{
+    events->index = index;
+    events->desc = desc;
+    events->label = label;
+    events->irq = 0;
+    events->debounce_us = 0;
+    atomic_long_set(&events->suppressed, 0);
+    init_waitqueue_head(&events->wait);
+    mutex_init(&events->read_lock);
+    INIT_DELAYED_WORK(&events->debounce_work, gpio_events_debounce_fn);
+}
+
+/*
+ * Function: __gpio_events_start
+ * -----------------------------
+ * Starts capturing. Called with read_lock held.
+ */
+static int __gpio_events_start(struct gpio_events *events)
+{
+    int irq, ret;
+
+    irq = gpiod_to_irq(events->desc);
+    if (irq < 0)
+    {
+        printk("GPIO pin %d can not be used as interrupt\n", desc_to_gpio(events->desc));
+        return irq;
+    }
+
+    events->head = 0;
+    events->tail = 0;
+    events->seqno = 0;
+    events->dropped = 0;
+    events->level = gpiod_get_value_cansleep(events->desc) ? 1 : 0;
+
+    /* Prefer the controller debounce, fall back to the software filter */
+    events->hw_debounce = events->debounce_us &&
+                          gpiod_set_debounce(events->desc, events->debounce_us) == 0;
+
+    ret = request_threaded_irq(irq, gpio_events_hardirq, gpio_events_thread,
+                               IRQF_TRIGGER_RISING | IRQF_TRIGGER_FALLING | IRQF_ONESHOT,
+                               events->label, events);
+    if (ret)
+    {
+        printk("Cannot request interrupt %d for GPIO pin %d\n", irq, desc_to_gpio(events->desc));
+        return ret;
+    }
+    WRITE_ONCE(events->irq, irq);
+    return 0;
+}
+
+/*
+ * Function: __gpio_events_stop
+ * ----------------------------
+ * Stops capturing. Called with read_lock held.
+ */
+static void __gpio_events_stop(struct gpio_events *events)
+{
+    if (!events->irq)
+    {
+        return;
+    }
+
+    free_irq(events->irq, events);
+    cancel_delayed_work_sync(&events->debounce_work);
+    if (events->hw_debounce)
+    {
+        gpiod_set_debounce(events->desc, 0);
+        events->hw_debounce = false;
+    }
+    WRITE_ONCE(events->irq, 0);
+    wake_up_interruptible_poll(&events->wait, EPOLLERR);
+}
+
+int gpio_events_start(struct gpio_events *events)
+{
+    int ret = 0;
+
+    mutex_lock(&events->read_lock);
+    if (!events->irq)
+    {
+        ret = __gpio_events_start(events);
+    }
+    mutex_unlock(&events->read_lock);
+    return ret;
+}
+
+void gpio_events_stop(struct gpio_events *events)
+{
+    mutex_lock(&events->read_lock);
+    __gpio_events_stop(events);
+    mutex_unlock(&events->read_lock);
+}
+
+int gpio_events_set_debounce(struct gpio_events *events, u32 debounce_us)
+{
+    int ret = 0;
+
+    mutex_lock(&events->read_lock);
+    events->debounce_us = debounce_us;
+    if (events->irq)
+    {
+        __gpio_events_stop(events);
+        ret = __gpio_events_start(events);
+    }
+    mutex_unlock(&events->read_lock);
+    return ret;
+}
+
+bool gpio_events_pending(struct gpio_events *events)
+{
+    return smp_load_acquire(&events->head) != READ_ONCE(events->tail);
+}
+
+ssize_t gpio_events_read(struct gpio_events *events, struct file *File, char __user *user_buffer, size_t count)
+{
+    size_t copied = 0;
+    unsigned int head, tail;
+    bool capturing;
+    int ret;
+
+    if (count < sizeof(struct tera_gpio_event))
+    {
+        return -EINVAL;
+    }
+
+    for (;;)
+    {
+        // Sampled before the drain: once capture stopped, no event arrives after it
+        capturing = READ_ONCE(events->irq);
+
+        if (mutex_lock_interruptible(&events->read_lock))
+        {
+            return -ERESTARTSYS;
+        }
+
+        tail = events->tail;
+        head = smp_load_acquire(&events->head);
+        while (head != tail && count - copied >= sizeof(struct tera_gpio_event))
+        {
+            if (copy_to_user(user_buffer + copied, &events->ring[tail & (GPIO_EVENTS_RING_SIZE - 1)],
+                             sizeof(struct tera_gpio_event)))
+            {
+                break;
+            }
+            tail++;
+            copied += sizeof(struct tera_gpio_event);
+        }
+
+        /* Hand the consumed slots back to the producer */
+        smp_store_release(&events->tail, tail);
+        mutex_unlock(&events->read_lock);
+
+        if (copied)
+        {
+            return copied;
+        }
+        if (head != tail)
+        {
+            return -EFAULT;
+        }
+        if (!capturing)
+        {
+            return -ENOSYS; // The pin is an output and the events it captured were read
+        }
+        if (File->f_flags & O_NONBLOCK)
+        {
+            return -EAGAIN;
+        }
+
+        ret = wait_event_interruptible(events->wait,
+                                       gpio_events_pending(events) || !READ_ONCE(events->irq));
+        if (ret)
+        {
+            return ret;
+        }
+    }
+}
+
+__poll_t gpio_events_poll(struct gpio_events *events, struct file *File, poll_table *wait)
+{
+    __poll_t mask = 0;
+
+    poll_wait(File, &events->wait, wait);
+
+    if (gpio_events_pending(events))
+    {
+        mask |= EPOLLIN | EPOLLRDNORM;
+    }
+    if (!READ_ONCE(events->irq))
+    {
+        mask |= EPOLLERR;
+    }
+    return mask;
+}
@@ -0,0 +1,116 @@
+/*
+ * Author: Eng. Mostafa Tera
+ * Date: 19/10/2026
+ */
+
+#ifndef GPIO_EVENTS
+#define GPIO_EVENTS
+
+#include <linux/wait.h>
+#include <linux/mutex.h>
+#include <linux/poll.h>
+#include <linux/workqueue.h>
+#include <linux/atomic.h>
+#include <linux/gpio/consumer.h>
+#include "tera_gpio_uapi.h"
+
+/*
+ * GPIO_EVENTS_RING_SIZE: Number of edge events buffered per pin (power of two).
+ */
+#define GPIO_EVENTS_RING_SIZE 256
+
+/*
+ * Struct: gpio_events
+ * -------------------
+ * Edge capture state of one input pin. The ring has a single producer (the
+ * threaded interrupt handler) and a single consumer (readers serialised by
+ * read_lock), so head and tail are published with acquire/release ordering
+ * instead of a lock shared with the interrupt.
+ */
+struct gpio_events
+{
+    struct tera_gpio_event ring[GPIO_EVENTS_RING_SIZE];
+    unsigned int head;       /* Written only by the interrupt thread */
+    unsigned int tail;       /* Written only by readers */
+    u32 seqno;               /* Sequence number of the next event */
+    u32 dropped;             /* Events lost because the ring was full */
+    u64 irq_timestamp;       /* Time stamp taken in the hard interrupt handler */
+    struct gpio_desc *desc;  /* Descriptor of the pin, the first pin of a bank */
+    int index;               /* Minor number of the pin */
+    int irq;                 /* Interrupt of the pin, 0 while not capturing */
+    const char *label;       /* Name used for the interrupt */
+    wait_queue_head_t wait;  /* Readers waiting for events */
+    struct mutex read_lock;  /* Serialises readers and start/stop */
+
+    u32 debounce_us;                    /* Settle time, 0 disables the filter */
+    bool hw_debounce;                   /* The controller filters the edges itself */
+    int level;                          /* Last level delivered to readers */
+    u64 pending_timestamp;              /* Time stamp of the last edge of a burst */
+    struct delayed_work debounce_work;  /* Software filter, runs once the pin settled */
+    atomic_long_t suppressed;           /* Edges swallowed by the filter */
+};
+
+/*
+ * Function: gpio_events_setup
+ * ---------------------------
+ * Initialises the capture state of a pin. Called once from probe.
+ */
+void gpio_events_setup(struct gpio_events *events, int index, struct gpio_desc *desc, const char *label);
+
+/*
+ * Function: gpio_events_start
+ * ---------------------------
+ * Requests the pin interrupt on both edges and starts capturing.
+ * The pin must already be an input.
+ *
+ * Returns:
+ * - 0 on success, otherwise an error code.
+ */
+int gpio_events_start(struct gpio_events *events);
+
+/*
+ * Function: gpio_events_stop
+ * --------------------------
+ * Frees the pin interrupt and wakes up blocked readers.
+ */
+void gpio_events_stop(struct gpio_events *events);
+
+/*
+ * Function: gpio_events_set_debounce
+ * ----------------------------------
+ * Changes the settle time of the pin. A running capture is restarted so the
+ * controller debounce is programmed again.
+ *
+ * Returns:
+ * - 0 on success, otherwise an error code.
+ */
+int gpio_events_set_debounce(struct gpio_events *events, u32 debounce_us);
+
+/*
+ * Function: gpio_events_pending
+ * -----------------------------
+ * Checks whether the ring holds unread events, also after capture stopped.
+ */
+bool gpio_events_pending(struct gpio_events *events);
+
+/*
+ * Function: gpio_events_read
+ * --------------------------
+ * Copies whole struct tera_gpio_event records to user space, blocking until
+ * at least one is available unless the file is non-blocking. Events
+ * captured before the pin became an output can still be read.
+ *
+ * Returns:
+ * - Number of bytes copied, -ENOSYS when the pin is not capturing and no
+ *   event is left, otherwise an error code.
+ */
+ssize_t gpio_events_read(struct gpio_events *events, struct file *File, char __user *user_buffer, size_t count);
+
+/*
+ * Function: gpio_events_poll
+ * --------------------------
+ * Reports EPOLLIN when events are waiting to be read.
+ */
+__poll_t gpio_events_poll(struct gpio_events *events, struct file *File, poll_table *wait);
+
+#endif // !GPIO_EVENTS
@@ -0,0 +1,262 @@
+/*
+ * Author: Eng. Mostafa Tera
+ * Date: 19/10/2026
+ */
+
+#include <linux/list.h>
+#include <linux/mutex.h>
+#include <linux/of_platform.h>
+#include <linux/seq_file.h>
+#include <linux/slab.h>
+#include "file_operations.h"
+#include "gpio_overlay.h"
+
+/*
+ * Struct: gpio_overlay_dev
+ * ------------------------
+ * A platform device created by the notifier, destroyed again when the
+ * overlay that added its node is removed.
+ */
+struct gpio_overlay_dev
+{
+    struct list_head list;
+    struct platform_device *pdev;
+};
+
+/*
+ * Struct: gpio_overlay
+ * --------------------
+ * Notifier state and the timing of the last overlay changes.
+ */
+static struct gpio_overlay
+{
+    struct notifier_block nb;
+    const struct of_device_id *matches;
+    struct mutex lock;         /* Protects devs */
+    struct list_head devs;     /* Devices created by the notifier */
+    struct dentry *file;
+    struct device_node *root;  /* Root of the overlay being changed */
+    unsigned long action;      /* PRE_APPLY or PRE_REMOVE of that change */
+    unsigned int pending;      /* Fragments of the change without their POST_ yet */
+    u64 start_ns;              /* Time of the first PRE_ of the change */
+    u64 applies;
+    u64 removes;
+    u64 last_apply_ns;         /* PRE_APPLY to POST_APPLY of the last apply */
+    u64 last_remove_ns;        /* PRE_REMOVE to POST_REMOVE of the last remove */
+    u64 nodes_created;         /* Devices created by the notifier */
+} overlay;
+
+/*
+ * Function: gpio_overlay_populate
+ * -------------------------------
+ * Creates a device for every LED node below target that has none yet.
+ * of_platform_device_create skips nodes the OF core already populated.
+ */
+static void gpio_overlay_populate(struct device_node *target)
+{
+    struct gpio_overlay_dev *odev;
+    struct device_node *np;
+
+    for_each_available_child_of_node(target, np)
+    {
+        if (!of_match_node(overlay.matches, np) || of_node_check_flag(np, OF_POPULATED))
+        {
+            continue;
+        }
+        odev = kzalloc(sizeof(*odev), GFP_KERNEL);
+        if (odev == NULL)
+        {
+            of_node_put(np);
+            return;
+        }
+        odev->pdev = of_platform_device_create(np, NULL, NULL);
+        if (odev->pdev == NULL)
+        {
+            kfree(odev);
+            continue;
+        }
+        mutex_lock(&overlay.lock);
+        list_add(&odev->list, &overlay.devs);
+        overlay.nodes_created++;
+        mutex_unlock(&overlay.lock);
+    }
+}
+
+/*
+ * Function: gpio_overlay_depopulate
+ * ---------------------------------
+ * Destroys the devices the notifier created for the nodes an overlay is
+ * about to remove. Each one unbinds on its own, see device_remove.
+ */
+static void gpio_overlay_depopulate(struct device_node *target, struct device_node *fragment)
+{
+    struct gpio_overlay_dev *odev, *tmp;
+    struct device_node *child;
+
+    mutex_lock(&overlay.lock);
+    list_for_each_entry_safe(odev, tmp, &overlay.devs, list)
+    {
+        struct device_node *np = odev->pdev->dev.of_node;
+
+        if (np->parent != target)
+        {
+            continue;
+        }
+        for_each_child_of_node(fragment, child)
+        {
+            if (strcmp(kbasename(child->full_name), kbasename(np->full_name)) == 0)
+            {
+                of_platform_device_destroy(&odev->pdev->dev, NULL);
+                list_del(&odev->list);
+                kfree(odev);
+                of_node_put(child);
+                break;
+            }
+        }
+    }
+    mutex_unlock(&overlay.lock);
+}
+
+/*
+ * Function: gpio_overlay_pre
+ * --------------------------
+ * Counts the PRE_ notification of one fragment. The OF core sends the PRE_
+ * of every fragment first and then every POST_, so the first PRE_ of an
+ * overlay (a new root or a new action) starts the timing.
+ */
+static void gpio_overlay_pre(struct device_node *fragment, unsigned long action)
+{
+    struct device_node *root = fragment;
+
+    while (root->parent)
+    {
+        root = root->parent;
+    }
+    if (root != overlay.root || action != overlay.action)
+    {
+        overlay.root = root;
+        overlay.action = action;
+        overlay.pending = 0; // A change aborted after its PRE_ never sends the POST_
+        overlay.start_ns = ktime_get_ns();
+    }
+    overlay.pending++;
+}
+
+/*
+ * Function: gpio_overlay_post
+ * ---------------------------
+ * Counts the POST_ notification of one fragment.
+ *
+ * Returns:
+ * - true for the last fragment, when the whole overlay is applied or removed.
+ */
+static bool gpio_overlay_post(void)
+{
+    if (overlay.pending == 0)
+    {
+        return false;
+    }
+    if (--overlay.pending)
+    {
+        return false;
+    }
+    overlay.root = NULL;
+    return true;
+}
+
+/*
+ * Function: gpio_overlay_notify
+ * -----------------------------
+ * OF overlay notifier, called with the OF mutex held once per fragment of
+ * every overlay apply and remove. The timing and the counters cover the
+ * whole overlay.
+ */
+static int gpio_overlay_notify(struct notifier_block *nb, unsigned long action, void *data)
+{
+    struct of_overlay_notify_data *nd = data;
+
+    switch (action)
+    {
+    case OF_OVERLAY_PRE_APPLY:
+    case OF_OVERLAY_PRE_REMOVE:
+        gpio_overlay_pre(nd->overlay, action);
+        if (action == OF_OVERLAY_PRE_REMOVE)
+        {
+            gpio_overlay_depopulate(nd->target, nd->overlay);
+        }
+        break;
+    case OF_OVERLAY_POST_APPLY:
+        gpio_overlay_populate(nd->target);
+        if (gpio_overlay_post())
+        {
+            overlay.last_apply_ns = ktime_get_ns() - overlay.start_ns;
+            overlay.applies++;
+        }
+        break;
+    case OF_OVERLAY_POST_REMOVE:
+        if (gpio_overlay_post())
+        {
+            overlay.last_remove_ns = ktime_get_ns() - overlay.start_ns;
+            overlay.removes++;
+        }
+        break;
+    }
+    return NOTIFY_OK;
+}
+
+/*
+ * Function: gpio_overlay_show
+ * ---------------------------
+ * debugfs file overlay, one "name value" line per counter.
+ */
+static int gpio_overlay_show(struct seq_file *s, void *unused)
+{
+    seq_printf(s, "applies %llu\n", overlay.applies);
+    seq_printf(s, "removes %llu\n", overlay.removes);
+    seq_printf(s, "last_apply_ns %llu\n", overlay.last_apply_ns);
+    seq_printf(s, "last_remove_ns %llu\n", overlay.last_remove_ns);
+    seq_printf(s, "nodes_created %llu\n", overlay.nodes_created);
+    return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(gpio_overlay);
+
+int gpio_overlay_init(const struct of_device_id *matches, struct dentry *parent)
+{
+    int ret;
+
+    overlay.matches = matches;
+    mutex_init(&overlay.lock);
+    INIT_LIST_HEAD(&overlay.devs);
+
+    if (!IS_ENABLED(CONFIG_OF_OVERLAY))
+    {
+        return 0; // Nothing to watch, the LED nodes come from the base device tree only
+    }
+
+    overlay.nb.notifier_call = gpio_overlay_notify;
+    ret = of_overlay_notifier_register(&overlay.nb);
+    if (ret)
+    {
+        return ret;
+    }
+    overlay.file = debugfs_create_file("overlay", 0444, parent, NULL, &gpio_overlay_fops);
+    return 0;
+}
+
+void gpio_overlay_exit(void)
+{
+    struct gpio_overlay_dev *odev, *tmp;
+
+    if (IS_ENABLED(CONFIG_OF_OVERLAY))
+    {
+        of_overlay_notifier_unregister(&overlay.nb);
+        debugfs_remove(overlay.file);
+    }
+
+    list_for_each_entry_safe(odev, tmp, &overlay.devs, list)
+    {
+        of_platform_device_destroy(&odev->pdev->dev, NULL);
+        list_del(&odev->list);
+        kfree(odev);
+    }
+}
@@ -0,0 +1,37 @@
+/*
+ * Author: Eng. Mostafa Tera
+ * Date: 19/10/2026
+ */
+
+#ifndef GPIO_OVERLAY
+#define GPIO_OVERLAY
+
+#include <linux/of.h>
+#include <linux/debugfs.h>
+
+/*
+ * Function: gpio_overlay_init
+ * ---------------------------
+ * Registers the OF overlay notifier. LED nodes added by an overlay below a
+ * node that is not a populated bus get a platform device from here, the
+ * others are created by the OF core. Either way every node binds and
+ * unbinds on its own. The time of every apply and remove is shown in
+ * debugfs, in the overlay file below parent.
+ *
+ * Parameters:
+ * - matches: Compatibles of the LED nodes.
+ * - parent: debugfs directory of the module.
+ *
+ * Returns:
+ * - 0 on success, otherwise an error code.
+ */
+int gpio_overlay_init(const struct of_device_id *matches, struct dentry *parent);
+
+/*
+ * Function: gpio_overlay_exit
+ * ---------------------------
+ * Unregisters the notifier and destroys the devices it created.
+ */
+void gpio_overlay_exit(void);
+
+#endif // !GPIO_OVERLAY
@@ -0,0 +1,264 @@
+/*
+ * Author: Eng. Mostafa Tera
+ * Date: 19/10/2026
+ */
+
+#include <linux/slab.h>
+#include "file_operations.h"
+#include "gpio_sampler.h"
+
+/*
+ * Function: gpio_sampler_push
+ * ---------------------------
+ * Appends one sample to the ring, dropping it when the reader did not keep
+ * up. The sequence number still advances, so the gap shows the loss.
+ */
+static void gpio_sampler_push(struct gpio_sampler *sampler, u64 timestamp, int level)
+{
+    unsigned int head = sampler->head;
+    unsigned int tail = smp_load_acquire(&sampler->tail);
+    struct tera_gpio_sample *sample;
+
+    if (head - tail >= GPIO_SAMPLER_RING_SIZE)
+    {
+        sampler->seqno++;
+        tera_stats_add(&sampler->node->stats, TERA_PATH_READ, TERA_STAT_DROPS, 1);
+        return;
+    }
+
+    sample = &sampler->ring[head & (GPIO_SAMPLER_RING_SIZE - 1)];
+    sample->timestamp_ns = timestamp;
+    sample->seqno = sampler->seqno++;
+    sample->level = level > 0;
+
+    /* Publish the slot before the new head */
+    smp_store_release(&sampler->head, head + 1);
+    wake_up_interruptible(&sampler->wait);
+}
+
+/*
+ * Function: gpio_sampler_work_fn
+ * ------------------------------
+ * Takes the sample of a pin behind a sleeping controller.
+ */
+static void gpio_sampler_work_fn(struct work_struct *work)
+{
+    struct gpio_sampler *sampler = container_of(work, struct gpio_sampler, work);
+    int direction;
+
+    sampler->seqno += atomic_xchg(&sampler->missed, 0); // Leave a gap for the samples the timer dropped
+    gpio_sampler_push(sampler, READ_ONCE(sampler->fired_ns), tera_node_level(sampler->node, &direction));
+}
+
+/*
+ * Function: gpio_sampler_timer_fn
+ * -------------------------------
+ * hrtimer callback. Outputs are sampled from the published state, inputs
+ * from the pin. Only one context produces samples: this callback, or the
+ * work item when the controller sleeps. device_remove cancels the timer
+ * before the pin is released.
+ */
+static enum hrtimer_restart gpio_sampler_timer_fn(struct hrtimer *timer)
+{
+    struct gpio_sampler *sampler = container_of(timer, struct gpio_sampler, timer);
+    struct tera_node *node = sampler->node;
+    u64 now = ktime_get_ns();
+    int direction, level;
+
+    if (sampler->sleeping)
+    {
+        WRITE_ONCE(sampler->fired_ns, now);
+        if (!queue_work(system_highpri_wq, &sampler->work))
+        {
+            // The last sample is still pending, this one is lost
+            atomic_inc(&sampler->missed);
+            tera_stats_add(&node->stats, TERA_PATH_READ, TERA_STAT_DROPS, 1);
+        }
+    }
+    else
+    {
+        tera_node_state(node, &direction, &level);
+        if (direction == TERA_GPIO_DIR_INPUT)
+        {
+            level = gpiod_get_value(node->desc);
+        }
+        gpio_sampler_push(sampler, now, level);
+    }
+
+    hrtimer_forward_now(timer, sampler->period);
+    return HRTIMER_RESTART;
+}
+
+struct gpio_sampler *gpio_sampler_create(struct tera_node *node)
+{
+    struct gpio_sampler *sampler;
+
+    sampler = kzalloc(sizeof(*sampler), GFP_KERNEL);
+    if (sampler == NULL)
+    {
+        return NULL;
+    }
+    sampler->node = node;
+    sampler->sleeping = gpiod_cansleep(node->desc);
+    hrtimer_setup(&sampler->timer, gpio_sampler_timer_fn, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+    INIT_WORK(&sampler->work, gpio_sampler_work_fn);
+    init_waitqueue_head(&sampler->wait);
+    mutex_init(&sampler->read_lock);
+
+    mutex_lock(&node->lock);
+    list_add(&sampler->entry, &node->samplers);
+    mutex_unlock(&node->lock);
+    return sampler;
+}
+
+int gpio_sampler_start(struct gpio_sampler *sampler, u32 period_us)
+{
+    struct tera_node *node = sampler->node;
+    int ret = 0;
+
+    gpio_sampler_stop(sampler);
+
+    mutex_lock(&sampler->read_lock);
+    sampler->head = 0;
+    sampler->tail = 0;
+    sampler->seqno = 0;
+    atomic_set(&sampler->missed, 0);
+    mutex_unlock(&sampler->read_lock);
+
+    sampler->period = us_to_ktime(period_us);
+
+    // Under node->lock, so device_remove either sees the sampler running or stops it first
+    mutex_lock(&node->lock);
+    if (node->removed)
+    {
+        ret = -ENODEV; // The node was unbound while the file was open
+    }
+    else
+    {
+        WRITE_ONCE(sampler->running, true);
+        hrtimer_start(&sampler->timer, 0, HRTIMER_MODE_REL); // First sample right away
+    }
+    mutex_unlock(&node->lock);
+    return ret;
+}
+
+void gpio_sampler_stop(struct gpio_sampler *sampler)
+{
+    WRITE_ONCE(sampler->running, false);
+    hrtimer_cancel(&sampler->timer);
+    cancel_work_sync(&sampler->work);
+    wake_up_interruptible_poll(&sampler->wait, EPOLLERR);
+}
+
+void gpio_sampler_stop_node(struct tera_node *node)
+{
+    struct gpio_sampler *sampler;
+
+    lockdep_assert_held(&node->lock);
+    list_for_each_entry(sampler, &node->samplers, entry)
+    {
+        gpio_sampler_stop(sampler);
+    }
+}
+
+void gpio_sampler_free(struct gpio_sampler *sampler)
+{
+    if (sampler == NULL)
+    {
+        return;
+    }
+    gpio_sampler_stop(sampler);
+
+    mutex_lock(&sampler->node->lock);
+    list_del(&sampler->entry);
+    mutex_unlock(&sampler->node->lock);
+    kfree(sampler);
+}
+
+/*
+ * Function: gpio_sampler_pending
+ * ------------------------------
+ * Checks whether the ring holds unread samples.
+ */
+static bool gpio_sampler_pending(struct gpio_sampler *sampler)
+{
+    return smp_load_acquire(&sampler->head) != READ_ONCE(sampler->tail);
+}
+
+ssize_t gpio_sampler_read(struct gpio_sampler *sampler, struct file *File, char __user *user_buffer, size_t count)
+{
+    size_t copied = 0;
+    unsigned int head, tail;
+    int ret;
+
+    if (count < sizeof(struct tera_gpio_sample))
+    {
+        return -EINVAL;
+    }
+
+    for (;;)
+    {
+        if (mutex_lock_interruptible(&sampler->read_lock))
+        {
+            return -ERESTARTSYS;
+        }
+
+        tail = sampler->tail;
+        head = smp_load_acquire(&sampler->head);
+        while (head != tail && count - copied >= sizeof(struct tera_gpio_sample))
+        {
+            if (copy_to_user(user_buffer + copied, &sampler->ring[tail & (GPIO_SAMPLER_RING_SIZE - 1)],
+                             sizeof(struct tera_gpio_sample)))
+            {
+                break;
+            }
+            tail++;
+            copied += sizeof(struct tera_gpio_sample);
+        }
+
+        /* Hand the consumed slots back to the producer */
+        smp_store_release(&sampler->tail, tail);
+        mutex_unlock(&sampler->read_lock);
+
+        if (copied)
+        {
+            return copied;
+        }
+        if (head != tail)
+        {
+            return -EFAULT;
+        }
+        if (!READ_ONCE(sampler->running))
+        {
+            return -ENOSYS; // Stopped and drained
+        }
+        if (File->f_flags & O_NONBLOCK)
+        {
+            return -EAGAIN;
+        }
+
+        ret = wait_event_interruptible(sampler->wait,
+                                       gpio_sampler_pending(sampler) || !READ_ONCE(sampler->running));
+        if (ret)
+        {
+            return ret;
+        }
+    }
+}
+
+__poll_t gpio_sampler_poll(struct gpio_sampler *sampler, struct file *File, poll_table *wait)
+{
+    __poll_t mask = 0;
+
+    poll_wait(File, &sampler->wait, wait);
+
+    if (gpio_sampler_pending(sampler))
+    {
+        mask |= EPOLLIN | EPOLLRDNORM;
+    }
+    if (!READ_ONCE(sampler->running))
+    {
+        mask |= EPOLLERR;
+    }
+    return mask;
+}
@@ -0,0 +1,115 @@
+/*
+ * Author: Eng. Mostafa Tera
+ * Date: 19/10/2026
+ */
+
+#ifndef GPIO_SAMPLER
+#define GPIO_SAMPLER
+
+#include <linux/hrtimer.h>
+#include <linux/wait.h>
+#include <linux/mutex.h>
+#include <linux/poll.h>
+#include <linux/workqueue.h>
+#include <linux/list.h>
+#include "tera_gpio_uapi.h"
+
+struct tera_node;
+
+/*
+ * GPIO_SAMPLER_RING_SIZE: Number of samples buffered per file (power of two).
+ */
+#define GPIO_SAMPLER_RING_SIZE 256
+
+/*
+ * Struct: gpio_sampler
+ * --------------------
+ * Level sampler of one opened device file. An hrtimer takes a sample every
+ * period, pins behind a sleeping controller are read from a work item it
+ * queues. Like the edge ring of gpio_events the ring has one producer and
+ * readers serialised by read_lock, so head and tail need no shared lock.
+ * The samplers of a node are listed in node->samplers, so device_remove can
+ * stop them before the pin is released.
+ */
+struct gpio_sampler
+{
+    struct tera_gpio_sample ring[GPIO_SAMPLER_RING_SIZE];
+    unsigned int head;       /* Written only by the producer */
+    unsigned int tail;       /* Written only by readers */
+    u32 seqno;               /* Sequence number of the next sample */
+    struct tera_node *node;  /* Node sampled, the file holds a reference */
+    struct hrtimer timer;    /* Fires every period */
+    ktime_t period;
+    bool running;            /* Sampling, cleared by gpio_sampler_stop */
+    bool sleeping;           /* The controller sleeps, samples are taken by work */
+    u64 fired_ns;            /* Time the timer fired, time stamp of the sample of work */
+    struct work_struct work; /* Takes the sample when the controller sleeps */
+    atomic_t missed;         /* Samples the timer dropped while work was pending */
+    struct list_head entry;  /* In node->samplers, under node->lock */
+    wait_queue_head_t wait;  /* Readers waiting for samples */
+    struct mutex read_lock;  /* Serialises readers */
+};
+
+/*
+ * Function: gpio_sampler_create
+ * -----------------------------
+ * Allocates a stopped sampler for node.
+ *
+ * Returns:
+ * - The sampler, NULL when out of memory.
+ */
+struct gpio_sampler *gpio_sampler_create(struct tera_node *node);
+
+/*
+ * Function: gpio_sampler_start
+ * ----------------------------
+ * Drops the buffered samples and (re)starts sampling at one sample every
+ * period_us microseconds.
+ *
+ * Returns:
+ * - 0 on success, -ENODEV when the node was unbound.
+ */
+int gpio_sampler_start(struct gpio_sampler *sampler, u32 period_us);
+
+/*
+ * Function: gpio_sampler_stop
+ * ---------------------------
+ * Stops sampling. Blocked readers return once the buffer is empty.
+ */
+void gpio_sampler_stop(struct gpio_sampler *sampler);
+
+/*
+ * Function: gpio_sampler_stop_node
+ * --------------------------------
+ * Stops every sampler of node. Called by device_remove with node->lock
+ * held, after setting node->removed, so no sampler starts again.
+ */
+void gpio_sampler_stop_node(struct tera_node *node);
+
+/*
+ * Function: gpio_sampler_free
+ * ---------------------------
+ * Stops a sampler and frees it. NULL is ignored.
+ */
+void gpio_sampler_free(struct gpio_sampler *sampler);
+
+/*
+ * Function: gpio_sampler_read
+ * ---------------------------
+ * Copies whole struct tera_gpio_sample records to user space, blocking
+ * until at least one is available unless the file is non-blocking.
+ *
+ * Returns:
+ * - Number of bytes copied, -ENOSYS when the sampler is stopped and empty,
+ *   otherwise an error code.
+ */
+ssize_t gpio_sampler_read(struct gpio_sampler *sampler, struct file *File, char __user *user_buffer, size_t count);
+
+/*
+ * Function: gpio_sampler_poll
+ * ---------------------------
+ * Reports EPOLLIN when samples are waiting to be read.
+ */
+__poll_t gpio_sampler_poll(struct gpio_sampler *sampler, struct file *File, poll_table *wait);
+
+#endif // !GPIO_SAMPLER
@@ -0,0 +1,196 @@
+/*
+ * Author: Eng. Mostafa Tera
+ * Date: 19/10/2026
+ */
+
+#include "file_operations.h"
+#include "gpio_shadow.h"
+#include "gpio_status.h"
+
+/*
+ * Function: gpio_shadow_pins
+ * --------------------------
+ * Mask of all pins of a node, bit I for pin I of the bank.
+ */
+static unsigned long gpio_shadow_pins(struct tera_node *node)
+{
+    return BITMAP_LAST_WORD_MASK(node->ngpios); // TERA_BANK_MAX_PINS fits in one word
+}
+
+/*
+ * Function: gpio_shadow_write
+ * ---------------------------
+ * Drives pin I of a node to bit I of levels. A bank goes through one array
+ * call, so pins on the same controller change together in one access.
+ */
+static void gpio_shadow_write(struct tera_node *node, unsigned long levels)
+{
+    if (node->ngpios == 1)
+    {
+        gpiod_set_value_cansleep(node->desc, levels & 1);
+        return;
+    }
+
+    gpiod_set_array_value_cansleep(node->ngpios, node->bank->desc, node->bank->info, &levels);
+}
+
+/*
+ * Function: gpio_shadow_update
+ * ----------------------------
+ * Drives the pins in mask to their bit of values unless the cache shows
+ * they already hold them, see gpio_shadow_set_bank.
+ */
+static int gpio_shadow_update(struct gpio_shadow *shadow, struct tera_node *node, unsigned long mask, unsigned long values)
+{
+    int index = node->index;
+    u64 start = tera_stats_start(), ns;
+    bool changed = false;
+    unsigned long levels;
+
+    mutex_lock(&shadow->lock);
+
+    if (!test_bit(index, shadow->valid))
+    {
+        mutex_unlock(&shadow->lock);
+        return -EINVAL; // Inputs are not driven, their published state stays as is
+    }
+
+    levels = (shadow->levels[index] & ~mask) | (values & mask);
+    if (levels == shadow->levels[index])
+    {
+        shadow->hits[index]++; // The pins already hold these levels
+    }
+    else
+    {
+        gpio_shadow_write(node, levels);
+        shadow->levels[index] = levels;
+        shadow->misses[index]++;
+        tera_pmu_add(TERA_PMU_GPIO_TOGGLES, 1);
+        tera_node_publish(node, TERA_GPIO_DIR_OUTPUT, levels & 1);
+        changed = true;
+    }
+
+    mutex_unlock(&shadow->lock);
+    if (changed)
+    {
+        tera_node_changed(node, false);
+    }
+    ns = tera_stats_op(&node->stats, TERA_PATH_GPIO_SET, 1, 1, start);
+    trace_tera_gpio_set(index, desc_to_gpio(node->desc), levels & 1, ns);
+    return 0;
+}
+
+void gpio_shadow_init(struct gpio_shadow *shadow)
+{
+    mutex_init(&shadow->lock);
+    bitmap_zero(shadow->valid, TERA_SHADOW_PINS);
+    memset(shadow->levels, 0, sizeof(shadow->levels));
+    memset(shadow->hits, 0, sizeof(shadow->hits));
+    memset(shadow->misses, 0, sizeof(shadow->misses));
+}
+
+void gpio_shadow_set(struct gpio_shadow *shadow, struct tera_node *node, int value)
+{
+    gpio_shadow_update(shadow, node, gpio_shadow_pins(node), value ? ~0UL : 0);
+}
+
+int gpio_shadow_set_bank(struct gpio_shadow *shadow, struct tera_node *node, unsigned long mask, unsigned long values)
+{
+    if (mask & ~gpio_shadow_pins(node))
+    {
+        return -EINVAL; // The bank has no such pin
+    }
+    return gpio_shadow_update(shadow, node, mask, values);
+}
+
+int gpio_shadow_get(struct gpio_shadow *shadow, struct tera_node *node)
+{
+    int index = node->index;
+    int value;
+
+    mutex_lock(&shadow->lock);
+
+    if (test_bit(index, shadow->valid))
+    {
+        value = shadow->levels[index] & 1;
+        shadow->hits[index]++;
+    }
+    else
+    {
+        value = gpiod_get_value_cansleep(node->desc); // Input pins always read the controller
+        shadow->misses[index]++;
+    }
+
+    mutex_unlock(&shadow->lock);
+    return value;
+}
+
+int gpio_shadow_direction_output(struct gpio_shadow *shadow, struct tera_node *node, int value)
+{
+    int index = node->index;
+    unsigned int i;
+    int ret = 0;
+
+    value = !!value;
+
+    mutex_lock(&shadow->lock);
+
+    for (i = 0; i < node->ngpios && ret == 0; i++)
+    {
+        ret = gpiod_direction_output(node->ngpios == 1 ? node->desc : node->bank->desc[i], value);
+    }
+    if (ret == 0)
+    {
+        shadow->levels[index] = value ? gpio_shadow_pins(node) : 0;
+        __set_bit(index, shadow->valid);
+        tera_node_publish(node, TERA_GPIO_DIR_OUTPUT, value);
+    }
+    else
+    {
+        __clear_bit(index, shadow->valid);
+    }
+
+    mutex_unlock(&shadow->lock);
+    return ret;
+}
+
+int gpio_shadow_direction_input(struct gpio_shadow *shadow, struct tera_node *node)
+{
+    int index = node->index;
+    unsigned int i;
+    int ret = 0;
+
+    mutex_lock(&shadow->lock);
+    __clear_bit(index, shadow->valid);
+    for (i = 0; i < node->ngpios && ret == 0; i++)
+    {
+        ret = gpiod_direction_input(node->ngpios == 1 ? node->desc : node->bank->desc[i]);
+    }
+    if (ret == 0)
+    {
+        tera_node_publish(node, TERA_GPIO_DIR_INPUT, gpiod_get_value_cansleep(node->desc));
+    }
+    mutex_unlock(&shadow->lock);
+
+    return ret;
+}
+
+bool gpio_shadow_is_output(struct gpio_shadow *shadow, int index)
+{
+    return test_bit(index, shadow->valid);
+}
+
+void gpio_shadow_reset_counters(struct gpio_shadow *shadow, int index)
+{
+    mutex_lock(&shadow->lock);
+    shadow->hits[index] = 0;
+    shadow->misses[index] = 0;
+    mutex_unlock(&shadow->lock);
+}
+
+void gpio_shadow_invalidate(struct gpio_shadow *shadow, int index)
+{
+    mutex_lock(&shadow->lock);
+    __clear_bit(index, shadow->valid);
+    mutex_unlock(&shadow->lock);
+}
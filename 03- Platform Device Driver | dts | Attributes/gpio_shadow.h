@@ -0,0 +1,122 @@
+/*
+ * Author: Eng. Mostafa Tera
+ * Date: 19/10/2026
+ */
+
+#ifndef GPIO_SHADOW
+#define GPIO_SHADOW
+
+#include <linux/mutex.h>
+#include <linux/types.h>
+
+struct tera_node;
+
+/*
+ * TERA_SHADOW_PINS: Number of nodes covered by the cache, one per minor
+ * number (TERA_MAX_NODES). A node with several GPIOs is one bank and
+ * takes one slot, with one level bit per pin.
+ */
+#define TERA_SHADOW_PINS 256
+
+/*
+ * Struct: gpio_shadow
+ * -------------------
+ * Shadow copy of the output levels of the driver pins. A pin is cached only
+ * while it is an output driven by this driver, so redundant writes can be
+ * dropped and reads answered without touching the controller, which matters
+ * for expanders where every access is an I2C/SPI transfer.
+ */
+struct gpio_shadow
+{
+    struct mutex lock;                     /* Serialises the pin accesses, they may sleep */
+    DECLARE_BITMAP(valid, TERA_SHADOW_PINS); /* Bit N set: levels[N] matches node N */
+    unsigned long levels[TERA_SHADOW_PINS];  /* Last levels written to each node, bit I is pin I of the bank */
+    unsigned long hits[TERA_SHADOW_PINS];    /* Accesses served by the cache */
+    unsigned long misses[TERA_SHADOW_PINS];  /* Accesses that reached the controller */
+};
+
+/*
+ * Function: gpio_shadow_init
+ * --------------------------
+ * Initialises an empty cache.
+ */
+void gpio_shadow_init(struct gpio_shadow *shadow);
+
+/*
+ * Function: gpio_shadow_set
+ * -------------------------
+ * Drives all output pins of a node unless the cache shows they already
+ * hold value, and publishes the new level with tera_node_publish. Inputs
+ * are left alone. The pins of a bank are written with one array call.
+ */
+void gpio_shadow_set(struct gpio_shadow *shadow, struct tera_node *node, int value);
+
+/*
+ * Function: gpio_shadow_set_bank
+ * ------------------------------
+ * Drives every pin I of a bank set in mask to bit I of values, in one array
+ * call, and leaves the other pins at their level. Nothing is written when
+ * the cache shows the pins already hold these levels. The published level
+ * of a bank is the level of its first pin.
+ *
+ * Returns:
+ * - 0 on success, -EINVAL when the node is not an output or mask has bits
+ *   beyond its pins.
+ */
+int gpio_shadow_set_bank(struct gpio_shadow *shadow, struct tera_node *node, unsigned long mask, unsigned long values);
+
+/*
+ * Function: gpio_shadow_get
+ * -------------------------
+ * Returns the level of a node, from the cache for outputs. A bank reports
+ * its first pin.
+ *
+ * Returns:
+ * - 0 or 1, otherwise an error code.
+ */
+int gpio_shadow_get(struct gpio_shadow *shadow, struct tera_node *node);
+
+/*
+ * Function: gpio_shadow_direction_output
+ * --------------------------------------
+ * Switches the pins of a node to output at value and starts caching them.
+ *
+ * Returns:
+ * - 0 on success, otherwise an error code.
+ */
+int gpio_shadow_direction_output(struct gpio_shadow *shadow, struct tera_node *node, int value);
+
+/*
+ * Function: gpio_shadow_direction_input
+ * -------------------------------------
+ * Switches the pins of a node to input and stops caching them, their
+ * level now comes from outside.
+ *
+ * Returns:
+ * - 0 on success, otherwise an error code.
+ */
+int gpio_shadow_direction_input(struct gpio_shadow *shadow, struct tera_node *node);
+
+/*
+ * Function: gpio_shadow_is_output
+ * -------------------------------
+ * Checks whether the pin is an output driven by this driver.
+ */
+bool gpio_shadow_is_output(struct gpio_shadow *shadow, int index);
+
+/*
+ * Function: gpio_shadow_reset_counters
+ * ------------------------------------
+ * Clears the hit and miss counters of a pin. Minors are reused, so a newly
+ * probed node starts from zero instead of the counts of the last one.
+ */
+void gpio_shadow_reset_counters(struct gpio_shadow *shadow, int index);
+
+/*
+ * Function: gpio_shadow_invalidate
+ * --------------------------------
+ * Forgets the cached level of a pin, e.g. before it is released.
+ */
+void gpio_shadow_invalidate(struct gpio_shadow *shadow, int index);
+
+#endif // !GPIO_SHADOW
@@ -0,0 +1,107 @@
+/*
+ * Author: Eng. Mostafa Tera
+ * Date: 19/10/2026
+ */
+
+#include <linux/spinlock.h>
+#include <linux/gfp.h>
+#include "file_operations.h"
+#include "gpio_status.h"
+
+/*
+ * Struct: gpio_status
+ * -------------------
+ * The pages shared with user space and the lock that serialises their
+ * writers. Readers never take the lock, they follow the sequence count in
+ * the page. The area is split into order-0 pages, so each one can be
+ * inserted into a mapping on its own.
+ */
+static struct gpio_status
+{
+    spinlock_t lock;
+    struct tera_gpio_status_page *page;
+} status;
+
+int gpio_status_init(unsigned int npins)
+{
+    BUILD_BUG_ON(TERA_MAX_NODES > TERA_GPIO_STATUS_MAX_PINS); // Every minor has a slot
+
+    spin_lock_init(&status.lock);
+    status.page = alloc_pages_exact(sizeof(struct tera_gpio_status_page), GFP_KERNEL | __GFP_ZERO);
+    if (status.page == NULL)
+    {
+        return -ENOMEM;
+    }
+    status.page->npins = min_t(unsigned int, npins, TERA_GPIO_STATUS_MAX_PINS);
+    return 0;
+}
+
+void gpio_status_exit(void)
+{
+    free_pages_exact(status.page, sizeof(struct tera_gpio_status_page));
+    status.page = NULL;
+}
+
+void gpio_status_update(int index, int level, int direction)
+{
+    struct tera_gpio_status_page *page = status.page;
+    struct tera_gpio_status_pin *pin;
+    unsigned long flags;
+    u64 bit;
+
+    if (page == NULL || index < 0 || index >= TERA_GPIO_STATUS_MAX_PINS)
+    {
+        return;
+    }
+    pin = &page->pins[index];
+    bit = BIT_ULL(index % 64);
+    level = !!level;
+
+    spin_lock_irqsave(&status.lock, flags);
+
+    if (pin->level != level || pin->direction != direction || pin->changes == 0)
+    {
+        /* Odd sequence: readers retry until the update is complete */
+        WRITE_ONCE(page->seq, page->seq + 1);
+        smp_wmb();
+
+        pin->level = level;
+        pin->direction = direction;
+        pin->changes++;
+        pin->last_change_ns = ktime_get_ns();
+        page->levels[index / 64] = (page->levels[index / 64] & ~bit) | (level ? bit : 0);
+        page->directions[index / 64] = (page->directions[index / 64] & ~bit) |
+                                       (direction == TERA_GPIO_DIR_OUTPUT ? bit : 0);
+
+        smp_wmb();
+        WRITE_ONCE(page->seq, page->seq + 1);
+    }
+
+    spin_unlock_irqrestore(&status.lock, flags);
+}
+
+int gpio_status_mmap(struct file *File, struct vm_area_struct *vma)
+{
+    unsigned long offset;
+    int ret;
+
+    if (vma->vm_pgoff != 0 || vma->vm_end - vma->vm_start != PAGE_ALIGN(sizeof(struct tera_gpio_status_page)))
+    {
+        return -EINVAL;
+    }
+    if (vma->vm_flags & VM_WRITE)
+    {
+        return -EPERM; // Only the driver writes the page
+    }
+
+    vm_flags_clear(vma, VM_MAYWRITE);
+    for (offset = 0; offset < vma->vm_end - vma->vm_start; offset += PAGE_SIZE)
+    {
+        ret = vm_insert_page(vma, vma->vm_start + offset, virt_to_page((char *)status.page + offset));
+        if (ret)
+        {
+            return ret; // The pages already inserted go with the vma
+        }
+    }
+    return 0;
+}
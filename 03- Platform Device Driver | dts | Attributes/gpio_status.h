@@ -0,0 +1,49 @@
+/*
+ * Author: Eng. Mostafa Tera
+ * Date: 19/10/2026
+ */
+
+#ifndef GPIO_STATUS
+#define GPIO_STATUS
+
+#include <linux/mm.h>
+#include "tera_gpio_uapi.h"
+
+/*
+ * Function: gpio_status_init
+ * --------------------------
+ * Allocates the shared status page, one slot per minor number.
+ *
+ * Returns:
+ * - 0 on success, otherwise an error code.
+ */
+int gpio_status_init(unsigned int npins);
+
+/*
+ * Function: gpio_status_exit
+ * --------------------------
+ * Frees the status page. Existing mappings keep their reference to it.
+ */
+void gpio_status_exit(void);
+
+/*
+ * Function: gpio_status_update
+ * ----------------------------
+ * Publishes the level and direction of a pin. The change counter and time
+ * stamp only move when one of them differs from the page. Safe to call from
+ * any context.
+ */
+void gpio_status_update(int index, int level, int direction);
+
+/*
+ * Function: gpio_status_mmap
+ * --------------------------
+ * Maps the status page read-only into the caller. The mapping must start
+ * at offset 0 and cover the whole page, rounded up to the page size.
+ *
+ * Returns:
+ * - 0 on success, otherwise an error code.
+ */
+int gpio_status_mmap(struct file *File, struct vm_area_struct *vma);
+
+#endif // !GPIO_STATUS
@@ -4,6 +4,10 @@
  */
 
 #include "file_operations.h"
+#include "tera_led.h"
+#include "gpio_bulk.h"
+#include "gpio_overlay.h"
+#include "tera_props.h"
 
 /* Name of the driver module */
 #define DRIVER_NAME "teraDriver"
@@ -11,6 +15,9 @@
 /* Name of the driver class */
 #define DRIVER_CLASS "tera_class"
 
+/* debugfs directory below tera/, apart from the teraGPIO directory of the 02 driver */
+#define DEBUGFS_NAME "teraGPIO_dt"
+
 /* Specifies the license for the module (GPL - General Public License) */
 MODULE_LICENSE("GPL");
 
@@ -33,27 +40,36 @@ struct mydata
         .open = driver_open,     /* Open function for the device */
         .release = driver_close, /* Close function for the device */
         .read = driver_read,     /* Read function for the device */
-        .write = driver_write    /* Write function for the device */
+        .write = driver_write,   /* Write function for the device */
+        .poll = driver_poll,     /* Poll function for the device */
+        .unlocked_ioctl = driver_ioctl, /* Direction and read mode requests */
+        .mmap = driver_mmap      /* Mmap function for the device */
     }};
 
-// Buffer size and permission arrays for LED nodes
-int buff_size[2] = {0};
-int perm[2] = {0};
-int direction_pin2 = 1;
-int direction_pin3 = 1;
-char *global_label;
+/* debugfs directory of the module, /sys/kernel/debug/tera/teraGPIO_dt */
+static struct dentry *tera_debugfs;
+
+/* Probe the LED nodes in parallel with the rest of the boot */
+static bool probe_async = true;
+module_param(probe_async, bool, 0444);
+MODULE_PARM_DESC(probe_async, "Probe LED nodes asynchronously (default: true)");
 
-// Device IDs for LED nodes defined in Device Tree Source (DTS)
-const struct of_device_id platDeviceIdDTS[4] = {
+// Device IDs for LED nodes defined in Device Tree Source (DTS), tera,gpio-led fits any number of nodes
+const struct of_device_id platDeviceIdDTS[] = {
+    {.compatible = "tera,gpio-led"},
     {.compatible = "tera,led1"},
     {.compatible = "tera,led2"},
     {}
 };
+MODULE_DEVICE_TABLE(of, platDeviceIdDTS);
+
+/* Minor numbers handed out to the probed LED nodes */
+static DEFINE_IDA(teraMinors);
 
 /*
  * Function: teraShow1
  * --------------------
- * Function to read the value of LED nodes.
+ * Function to read the direction of LED nodes, "1" for output and "0" for input.
  *
  * Parameters:
  * - dev: Pointer to the device structure.
@@ -65,40 +81,9 @@ const struct of_device_id platDeviceIdDTS[4] = {
  */
 ssize_t teraShow1(struct device *dev, struct device_attribute *attr, char *buf)
 {
-    size_t len; // Variable to store length of read value
-    char *label; // Variable to store device label
+    struct tera_node *node = dev_get_drvdata(dev); // State saved earlier in probe function
 
-    // Restore the data saved earlier in probe function to use it
-    label = dev_get_drvdata(dev); // Retrieve label from driver data
-
-    // Check the label and set the value accordingly
-    if (strcmp(label, "redled_1") == 0) // Check if label is "redled_1"
-    {
-        if (direction_pin2 == 1) // Check if pin direction is output
-        {
-            strcpy(buf, "1"); // Set buffer to "1"
-            len = strlen("1"); // Update length
-        }
-        else if (direction_pin2 == 0) // Check if pin direction is input
-        {
-            strcpy(buf, "0"); // Set buffer to "0"
-            len = strlen("0"); // Update length
-        }
-    }
-    else if (strcmp(label, "redled_2") == 0) // Check if label is "redled_2"
-    {
-        if (direction_pin3 == 1) // Check if pin direction is output
-        {
-            strcpy(buf, "1"); // Set buffer to "1"
-            len = strlen("1"); // Update length
-        }
-        else if (direction_pin3 == 0) // Check if pin direction is input
-        {
-            strcpy(buf, "0"); // Set buffer to "0"
-            len = strlen("0"); // Update length
-        }
-    }
-    return len; // Return length of read value
+    return sysfs_emit(buf, "%d", tera_node_is_output(node)); // Never waits for a direction change
 }
 
 /*
@@ -120,117 +105,102 @@ ssize_t teraStore1(struct device *dev, struct device_attribute *attr, const char
     // Define constants for string representations of directions
     const char *direction_output = "output"; // Define string constant for "output"
     const char *direction_input = "input";   // Define string constant for "input"
-    char *label;                              // Variable to store device label
-
-    // Restore the data saved earlier in the probe function to use it
-    label = dev_get_drvdata(dev); // Retrieve label from driver data
+    struct tera_node *node = dev_get_drvdata(dev); // State saved earlier in probe function
+    int ret;
 
-    // Check the label and set the direction accordingly
-    if (strcmp(label, "redled_1") == 0) // Check if label is "redled_1"
+    // Check if the input string matches "output"
+    if (strncmp(buf, direction_output, strlen(direction_output)) == 0)
     {
-        // Check if the input string matches "output"
-        if (strncmp(buf, direction_output, strlen(direction_output)) == 0)
-        {
-            int current_gpio_value = gpio_get_value(2); // Get current GPIO value
-            gpio_direction_output(2, current_gpio_value); // Set GPIO pin direction as output
-            direction_pin2 = 1; // Update direction flag
-            printk("gpio direction is set to output for redled_1\n"); // Print message
-        }
-        // Check if the input string matches "input"
-        else if (strncmp(buf, direction_input, strlen(direction_input)) == 0)
-        {
-            gpio_direction_input(2); // Set GPIO pin direction as input
-            direction_pin2 = 0; // Update direction flag
-            printk("gpio direction is set to input for redled_1\n"); // Print message
-        }
-        else
-        {
-            return -EINVAL; // Return error if input is neither "output" nor "input"
-        }
+        ret = tera_node_set_direction(node, TERA_GPIO_DIR_OUTPUT); // Set GPIO pin direction as output
     }
-    else if (strcmp(label, "redled_2") == 0) // Check if label is "redled_2"
+    // Check if the input string matches "input"
+    else if (strncmp(buf, direction_input, strlen(direction_input)) == 0)
     {
-        // Check if the input string matches "output"
-        if (strncmp(buf, direction_output, strlen(direction_output)) == 0)
-        {
-            int current_gpio_value = gpio_get_value(3); // Get current GPIO value
-            gpio_direction_output(3, current_gpio_value); // Set GPIO pin direction as output
-            direction_pin3 = 1; // Update direction flag
-            printk("gpio direction is set to output for redled_2\n"); // Print message
-        }
-        // Check if the input string matches "input"
-        else if (strncmp(buf, direction_input, strlen(direction_input)) == 0)
-        {
-            gpio_direction_input(3); // Set GPIO pin direction as input
-            direction_pin3 = 0; // Update direction flag
-            printk("gpio direction is set to input for redled_2\n"); // Print message
-        }
-        else
-        {
-            return -EINVAL; // Return error if input is neither "output" nor "input"
-        }
+        ret = tera_node_set_direction(node, TERA_GPIO_DIR_INPUT); // Set GPIO pin direction as input
+    }
+    else
+    {
+        return -EINVAL; // Error if input is neither "output" nor "input"
+    }
+
+    if (ret)
+    {
+        return ret;
     }
+    dev_dbg(dev, "gpio direction is set to %s for %s\n", buf[0] == 'o' ? direction_output : direction_input, node->label);
     return count; // Return the number of bytes written
 }
 
-// Function to show the value attribute of LED nodes
+// Function to show the value attribute of LED nodes, output levels come from the published state without locking.
+// Every level change calls tera_node_changed, so poll() with POLLPRI on the attribute wakes up on changes
 ssize_t teraShow2(struct device *dev, struct device_attribute *attr, char *buf)
 {
-    char *label;
-    // Restore the data i saved earlier in probe function to use it
-    label = dev_get_drvdata(dev);
-    size_t len;
-    if (strcmp(label, "redled_1") == 0)
-    {
-        unsigned int gpio = 2; // GPIO pin number
-        int pin_value;
-
-        // Get the current value of the GPIO pin
-        pin_value = gpio_get_value(gpio);
-        if (pin_value < 0)
-        {
-            return pin_value; // Return error code
-        }
+    struct tera_node *node = dev_get_drvdata(dev);
+    int direction;
+    int pin_value = tera_node_level(node, &direction);
 
-        // Convert pin value to string format
-        const char *pin_value_str = (pin_value == 0) ? "0" : "1";
+    if (pin_value < 0)
+    {
+        return pin_value; // Return error code
+    }
+    return sysfs_emit(buf, "%d", pin_value != 0);
+}
 
-        // Copy pin value string to user buffer
-        len = strlen(pin_value_str);
-        if (len >= PAGE_SIZE)
-        {
-            return -ENOSPC; // Buffer overflow
-        }
-        strcpy(buf, pin_value_str);
+// Function to show the debounce time of LED nodes in microseconds
+ssize_t teraShow3(struct device *dev, struct device_attribute *attr, char *buf)
+{
+    struct tera_node *node = dev_get_drvdata(dev);
+
+    return sysfs_emit(buf, "%u\n", node->events.debounce_us);
+}
+
+// Function to store the debounce time of LED nodes in microseconds
+ssize_t teraStore3(struct device *dev, struct device_attribute *attr, const char *buf, size_t count)
+{
+    struct tera_node *node = dev_get_drvdata(dev);
+    u32 debounce_us;
+    int ret;
+
+    ret = kstrtou32(buf, 0, &debounce_us);
+    if (ret)
+    {
+        return ret; // Return error if input is not a number
     }
-    else if (strcmp(label, "redled_2") == 0)
+
+    ret = gpio_events_set_debounce(&node->events, debounce_us);
+    if (ret)
     {
-        unsigned int gpio = 3; // GPIO pin number
-        int pin_value;
+        return ret;
+    }
+    return count;
+}
 
-        // Get the current value of the GPIO pin
-        pin_value = gpio_get_value(gpio);
-        if (pin_value < 0)
-        {
-            return pin_value; // Return error code
-        }
+// Function to show how many edges the debounce filter suppressed
+ssize_t teraShow4(struct device *dev, struct device_attribute *attr, char *buf)
+{
+    struct tera_node *node = dev_get_drvdata(dev);
 
-        // Convert pin value to string format
-        const char *pin_value_str = (pin_value == 0) ? "0" : "1";
+    return sysfs_emit(buf, "%ld\n", atomic_long_read(&node->events.suppressed));
+}
 
-        // Copy pin value string to user buffer
-        len = strlen(pin_value_str);
-        if (len >= PAGE_SIZE)
-        {
-            return -ENOSPC; // Buffer overflow
-        }
-        strcpy(buf, pin_value_str);
-    }
-    return len;
+// Function to show how many pin accesses the shadow cache answered
+ssize_t teraShow5(struct device *dev, struct device_attribute *attr, char *buf)
+{
+    struct tera_node *node = dev_get_drvdata(dev);
+
+    return sysfs_emit(buf, "%lu\n", READ_ONCE(tera_shadow.hits[node->index]));
+}
+
+// Function to show how many pin accesses reached the GPIO controller
+ssize_t teraShow6(struct device *dev, struct device_attribute *attr, char *buf)
+{
+    struct tera_node *node = dev_get_drvdata(dev);
+
+    return sysfs_emit(buf, "%lu\n", READ_ONCE(tera_shadow.misses[node->index]));
 }
 
 // Attributes for LED nodes
-struct device_attribute myDevsAttr[2] =
+struct device_attribute myDevsAttr[] =
     {
         [0] = {
             .attr = {
@@ -239,181 +209,295 @@ struct device_attribute myDevsAttr[2] =
             },
             .show = teraShow1,
             .store = teraStore1},
-        [1] = {.attr = {.name = "value", .mode = S_IRUSR}, .show = teraShow2, .store = NULL}};
+        [1] = {.attr = {.name = "value", .mode = S_IRUSR}, .show = teraShow2, .store = NULL},
+        [2] = {
+            .attr = {
+                .name = "debounce_us",
+                .mode = S_IRUSR | S_IWUSR,
+            },
+            .show = teraShow3,
+            .store = teraStore3},
+        [3] = {.attr = {.name = "edges_suppressed", .mode = S_IRUSR}, .show = teraShow4, .store = NULL},
+        [4] = {.attr = {.name = "cache_hits", .mode = S_IRUSR}, .show = teraShow5, .store = NULL},
+        [5] = {.attr = {.name = "cache_misses", .mode = S_IRUSR}, .show = teraShow6, .store = NULL}};
+
+// Attribute group created on every LED node once it is probed
+static struct attribute *teraAttrs[] = {
+    &myDevsAttr[0].attr,
+    &myDevsAttr[1].attr,
+    &myDevsAttr[2].attr,
+    &myDevsAttr[3].attr,
+    &myDevsAttr[4].attr,
+    &myDevsAttr[5].attr,
+    NULL,
+};
+
+static const struct attribute_group teraGroup = {
+    .attrs = teraAttrs,
+};
+
+// devm action removing the device file of a LED node
+static void teraDestroyFile(void *chardev)
+{
+    device_unregister(chardev);
+}
+
+// devm action giving the minor number of a LED node back
+static void teraFreeMinor(void *data)
+{
+    struct tera_node *node = data;
+
+    ida_free(&teraMinors, node->index);
+}
+
+// devm action dropping the reference of probe to a LED node, open files may still hold theirs
+static void teraPutNode(void *data)
+{
+    tera_node_put(data);
+}
 
 /*
- * Function: prob_device
+ * Function: teraGetGpios
  * ----------------------
- * Probe function for the platform driver. Called when a device is detected.
- *
- * Parameters:
- * - sLED_P: Pointer to the platform device structure representing the detected device.
+ * Requests the pins of a LED node. The pins found by the GPIO core, in
+ * gpios or the ACPI _CRS, may be a bank of several pins. Nodes written for the older bindings give GPIO
+ * numbers in gpio_pin instead, several of them make a bank as well.
  *
  * Returns:
  * - 0 on success, otherwise an error code.
  */
-int prob_device(struct platform_device *sLED_P)
+static int teraGetGpios(struct device *dev, struct tera_node *node, const struct tera_props *props)
 {
-    struct device *dev = &sLED_P->dev; // Pointer to the device structure
-    int ret, led_value, gpio_pin; // Variables for return values and LED properties
-    const char *label; // Variable to store device label
+    unsigned int i;
+    int ret;
 
-    enum leds // Enum for LED node status
+    if (props->ngpios)
     {
-        redled_1, // Status for redled_1
-        redled_2  // Status for redled_2
-    } node_status;
-
-    printk("The probe function is called\n"); // Print message indicating probe function call
-
-    // Check for required device properties
-    if (!device_property_present(dev, "label"))
-    {
-        printk("Error, Device property 'label' not found\n"); // Print error message if label property not found
-        return -1; // Return error code
-    }
-    if (!device_property_present(dev, "led_value"))
-    {
-        printk("Error, Device property 'led_value' not found\n"); // Print error message if led_value property not found
-        return -1; // Return error code
-    }
-    if (!device_property_present(dev, "gpio_pin"))
-    {
-        printk("Error, Device property 'gpio_pin' not found\n"); // Print error message if gpio_pin property not found
-        return -1; // Return error code
+        // The levels are set by gpio_shadow_direction_output, -EPROBE_DEFER retries once the controller is there
+        node->bank = devm_gpiod_get_array(dev, NULL, GPIOD_ASIS);
+        if (IS_ERR(node->bank))
+        {
+            return dev_err_probe(dev, PTR_ERR(node->bank), "Cannot get the gpios of %s\n", node->label);
+        }
+        node->desc = node->bank->desc[0];
+        node->ngpios = node->bank->ndescs;
+        return 0;
     }
-    if (!device_property_present(dev, "buff_size"))
+
+    // Several GPIO numbers are driven like a gpios bank, without the array fast path of the GPIO core
+    if (props->npins > 1)
     {
-        printk("Error, Device property 'buff_size' not found\n"); // Print error message if buff_size property not found
-        return -1; // Return error code
+        node->bank = devm_kzalloc(dev, struct_size(node->bank, desc, props->npins), GFP_KERNEL);
+        if (node->bank == NULL)
+        {
+            return -ENOMEM;
+        }
+        node->bank->ndescs = props->npins;
     }
-    if (!device_property_present(dev, "perm"))
+
+    for (i = 0; i < props->npins; i++)
     {
-        printk("Error, Device property 'perm' not found\n"); // Print error message if perm property not found
-        return -1; // Return error code
+        // Request the GPIO pin, -EPROBE_DEFER retries the probe once its controller is registered
+        ret = devm_gpio_request(dev, props->gpio_pin[i], node->label);
+        if (ret)
+        {
+            return dev_err_probe(dev, ret, "Cannot allocate GPIO pin %u\n", props->gpio_pin[i]);
+        }
+        if (node->bank)
+        {
+            node->bank->desc[i] = gpio_to_desc(props->gpio_pin[i]);
+        }
     }
+    node->desc = gpio_to_desc(props->gpio_pin[0]);
+    node->ngpios = props->npins;
+    return 0;
+}
 
-    // Read device properties
-    ret = device_property_read_string(dev, "label", &label); // Read label property
+/*
+ * Function: teraProbeNode
+ * -----------------------
+ * Sets up one LED node for prob_device. Every resource, including the state
+ * of the node and its minor number, is device managed, so any number of
+ * nodes can come and go.
+ *
+ * Parameters:
+ * - sLED_P: Pointer to the platform device structure representing the detected device.
+ *
+ * Returns:
+ * - 0 on success, otherwise an error code.
+ */
+static int teraProbeNode(struct platform_device *sLED_P)
+{
+    struct device *dev = &sLED_P->dev; // Pointer to the device structure
+    struct tera_props props; // Properties of the node, checked against their schema
+    struct device *chardev; // Device file of the LED node
+    struct tera_node *node; // State of the LED node, kept in drvdata
+    int ret;
+
+    // Read and validate every property in one pass, DT, ACPI and software nodes alike
+    ret = tera_props_parse(dev, &props);
     if (ret)
     {
-        printk("Error, couldn't read 'label'\n"); // Print error message if label property cannot be read
-        return -1; // Return error code
+        return ret;
     }
-    // Print the label of the device
-    printk("label is %s\n", label);
-    // Set a global_label pointer to the label string
-    global_label = (char *)label;
-    // Store global_label in dev structure associated to the device called prob function
-    dev_set_drvdata(dev, global_label);
 
-    // Determine LED node status based on label
-    if (strcmp(label, "redled_1") == 0) // Check if label is "redled_1"
+    // Allocate the state of the node together with its data buffer, and store it in dev structure associated to the device called prob function
+    node = kzalloc(struct_size(node, buffer, props.buff_size), GFP_KERNEL);
+    if (node == NULL)
     {
-        node_status = redled_1; // Set node status to redled_1
+        return -ENOMEM;
     }
-    else if (strcmp(label, "redled_2") == 0) // Check if label is "redled_2"
+    kref_init(&node->ref);
+    ret = devm_add_action_or_reset(dev, teraPutNode, node);
+    if (ret)
     {
-        node_status = redled_2; // Set node status to redled_2
+        return ret;
     }
-
-    // Read LED properties
-    ret = device_property_read_u32(dev, "led_value", &led_value); // Read led_value property
+    node->buff_size = props.buff_size;
+    node->perm = props.perm;
+    node->dev = dev;
+    node->label = props.label;
+    node->direction = TERA_GPIO_DIR_OUTPUT;
+    seqlock_init(&node->state);
+    mutex_init(&node->lock);
+    INIT_LIST_HEAD(&node->samplers);
+    dev_set_drvdata(dev, node);
+
+    // Take the lowest free minor number
+    ret = ida_alloc_max(&teraMinors, TERA_MAX_NODES - 1, GFP_KERNEL);
+    if (ret < 0)
+    {
+        return dev_err_probe(dev, ret, "No minor number left for %s\n", node->label);
+    }
+    node->index = ret;
+    ret = devm_add_action_or_reset(dev, teraFreeMinor, node);
     if (ret)
     {
-        printk("Error, couldn't read 'led_value' for %s\n", label); // Print error message if led_value property cannot be read
-        return -1; // Return error code
+        return ret;
     }
-    printk("led_value is %d\n", led_value); // Print led_value
 
-    ret = device_property_read_u32(dev, "gpio_pin", &gpio_pin); // Read gpio_pin property
+    // Allocate the per-CPU counters of the node, they are freed with the node
+    ret = tera_stats_init(&node->stats);
     if (ret)
     {
-        printk("Error, couldn't read 'gpio_pin' for %s\n", label); // Print error message if gpio_pin property cannot be read
-        return -1; // Return error code
+        return ret;
     }
-    printk("gpio_pin is %d\n", gpio_pin); // Print gpio_pin
 
-    // Read additional properties
-    ret = device_property_read_u32(dev, "buff_size", &buff_size[node_status]); // Read buff_size property
+    // Request the pins of the node
+    ret = teraGetGpios(dev, node, &props);
     if (ret)
     {
-        printk("Error, couldn't read 'buff_size' for %s\n", label); // Print error message if buff_size property cannot be read
-        return -1; // Return error code
+        return ret;
     }
-    printk("buff_size is %d\n", buff_size[node_status]); // Print buff_size
 
-    ret = device_property_read_u32(dev, "perm", &perm[node_status]); // Read perm property
+    // Prepare edge capture, it starts when the pin is switched to input
+    gpio_events_setup(&node->events, node->index, node->desc, node->label);
+
+    // Optional settle time of the input, it can also be changed through sysfs
+    node->events.debounce_us = props.debounce_us;
+
+    gpio_shadow_reset_counters(&tera_shadow, node->index); // The minor may have served an earlier node
+    ret = gpio_shadow_direction_output(&tera_shadow, node, props.led_value); // Set GPIO pin direction
     if (ret)
     {
-        printk("Error, couldn't read 'perm'\n"); // Print error message if perm property cannot be read
-        return -1; // Return error code
+        return dev_err_probe(dev, ret, "Cannot set the GPIO pins of %s to be output\n", node->label);
     }
-    printk("perm is %d\n", perm[node_status]); // Print perm
 
-    // Request and configure GPIO pin
-    if (gpio_request(gpio_pin, "LED_pin")) // Request GPIO pin
-    {
-        printk("Cannot allocate GPIO pin %d\n", gpio_pin); // Print error message if GPIO pin allocation fails
-    }
-    else
+    // Create device file for the detected device, devm removes it again on unbind
+    chardev = device_create(teraData_st.my_class, dev, teraData_st.my_device_nr + node->index, NULL, node->label);
+    if (IS_ERR(chardev))
     {
-        printk("GPIO pin %d allocated successfully\n", gpio_pin); // Print success message if GPIO pin allocation is successful
+        return dev_err_probe(dev, PTR_ERR(chardev), "Can not create device file for %s!\n", node->label);
     }
-    if (gpio_direction_output(gpio_pin, led_value)) // Set GPIO pin direction
+    ret = devm_add_action_or_reset(dev, teraDestroyFile, chardev);
+    if (ret)
     {
-        printk("Cannot set the GPIO pin %d to be output\n", gpio_pin); // Print error message if GPIO pin direction setting fails
-        gpio_free(gpio_pin); // Free GPIO pin
+        return ret;
     }
-    else
+
+    // Expose the node to the LED class, so kernel triggers can drive it
+    ret = tera_led_register(dev, node);
+    if (ret)
     {
-        printk("GPIO pin %d set to be output\n", gpio_pin); // Print success message if GPIO pin direction is set successfully
+        return dev_err_probe(dev, ret, "Can not register LED class device for %s!\n", node->label);
     }
 
-    // Create device file for the detected device
-    if (device_create(teraData_st.my_class, NULL, teraData_st.my_device_nr + (node_status), NULL, label) == NULL)
+    // Publish the counters and latency histograms of the node
+    tera_stats_debugfs(&node->stats, tera_debugfs, node->label);
+
+    // Create the attributes here rather than through dev_groups, which only
+    // adds them after probe returned, so their kernfs nodes can be kept for
+    // tera_node_changed. The node drops them when it is freed.
+    ret = devm_device_add_group(dev, &teraGroup);
+    if (ret)
     {
-        printk("Can not create device file for %s!\n", label); // Print error message if device file creation fails
+        return dev_err_probe(dev, ret, "Can not create the attributes of %s!\n", node->label);
     }
-    else
+    node->value_kn = sysfs_get_dirent(dev->kobj.sd, "value");
+    node->direction_kn = sysfs_get_dirent(dev->kobj.sd, "direction");
+    if (node->value_kn == NULL || node->direction_kn == NULL)
     {
-        printk("Device file Created for %s!\n", label); // Print success message if device file is created successfully
+        return dev_err_probe(dev, -ENOENT, "Attributes of %s not found!\n", node->label);
     }
 
-    // Create attributes for the device
-    printk("Creating the attributes for %s \n", label); // Print message indicating attribute creation
-    int i = 0; // Counter variable
-    for (i = 0; i < 2; i++) // Loop through attributes
-    {
-        int retval = device_create_file(dev, &(myDevsAttr[i])); // Create attribute file
-        if (retval)
-        {
-            printk("Failed to create sysfs attribute file\n"); // Print error message if attribute file creation fails
-            return retval; // Return error code
-        }
-    }
-    printk("Done Creating the attributes for %s \n", label); // Print message indicating attribute creation completion
+    // Let open and the bulk state file find the node of this minor
+    mutex_lock(&tera_nodes_lock);
+    WRITE_ONCE(tera_nodes[node->index], node);
+    mutex_unlock(&tera_nodes_lock);
+
     return 0; // Return success
 }
 
-// Function called when removing a platform device
+/*
+ * Function: prob_device
+ * ----------------------
+ * Probe function for the platform driver. Called when a device is detected,
+ * reports the probe time through the tera_probe tracepoint.
+ *
+ * Parameters:
+ * - sLED_P: Pointer to the platform device structure representing the detected device.
+ *
+ * Returns:
+ * - 0 on success, otherwise an error code.
+ */
+int prob_device(struct platform_device *sLED_P)
+{
+    u64 start = tera_stats_start();
+    int ret = teraProbeNode(sLED_P);
+
+    trace_tera_probe(dev_name(&sLED_P->dev), ret ? -1 : ((struct tera_node *)platform_get_drvdata(sLED_P))->index, ret, tera_stats_start() - start);
+    return ret;
+}
+
+// Function called when removing a platform device, the GPIO pin and the device file are released by devm
 int device_remove(struct platform_device *sLED_P)
 {
-    // Reset and free GPIO pins
-    gpio_set_value(2, 0);
-    gpio_free(2);
-    gpio_set_value(3, 0);
-    gpio_free(3);
+    struct tera_node *node = platform_get_drvdata(sLED_P);
+
+    // New opens of the minor fail from now on, and the bulk state file skips it
+    mutex_lock(&tera_nodes_lock);
+    WRITE_ONCE(tera_nodes[node->index], NULL);
+    mutex_unlock(&tera_nodes_lock);
+
+    // Files still open on the node fail their writes from now on, the node is freed on their last close
+    mutex_lock(&node->lock);
+    node->removed = true;
+    gpio_sampler_stop_node(node); // No sample is taken once the pin is released
+    mutex_unlock(&node->lock);
 
-    // Destroy device files associated with the device
-    int i = 0;
-    for (i = 0; i < 2; i++)
+    // Stop capturing edges before the pin is released
+    gpio_events_stop(&node->events);
+
+    // Turn the LED off and forget its cached level
+    if (gpio_shadow_is_output(&tera_shadow, node->index))
     {
-        device_destroy(teraData_st.my_class, teraData_st.my_device_nr + i);
+        gpio_shadow_set(&tera_shadow, node, 0);
     }
+    gpio_shadow_invalidate(&tera_shadow, node->index);
+
+    tera_stats_debugfs_remove(&node->stats);
 
-    printk("device_remove"); // Print a message indicating device removal
-    return 0;                // Return success
+    return 0; // Return success
 }
 
 // Structure holding platform driver data
@@ -423,59 +507,113 @@ struct platform_driver platform_driver_data =
         .remove = device_remove,
         .driver = {
             .name = "mydriver",
-            .of_match_table = platDeviceIdDTS}};
+            .of_match_table = platDeviceIdDTS,
+            .groups = gpio_bulk_groups, // state
+            .probe_type = PROBE_PREFER_ASYNCHRONOUS}};
 
 // Initialization function for the module
 static int __init teraINIT(void)
 {
     printk("PLatform driver inserted\n");
 
+    // The counters of every LED node are allocated in probe, they live below this directory
+    tera_debugfs = tera_stats_module_dir(DEBUGFS_NAME);
+
     // Allocate character device region
-    if (alloc_chrdev_region(&teraData_st.my_device_nr, 0, 2, DRIVER_NAME) < 0)
+    if (alloc_chrdev_region(&teraData_st.my_device_nr, 0, TERA_MAX_NODES, DRIVER_NAME) < 0)
     {
         printk("Device Nr. could not be allocated!\n");
-        return -1;
+        goto RegionError;
     }
 
     // Initialize the character device
     cdev_init(&teraData_st.cdev_object, &teraData_st.fops);
 
     // Add the character device to the kernel
-    if (cdev_add(&teraData_st.cdev_object, teraData_st.my_device_nr, 2) == -1)
+    if (cdev_add(&teraData_st.cdev_object, teraData_st.my_device_nr, TERA_MAX_NODES) < 0)
     {
         printk("Adding the device to the kernel failed!\n");
+        goto CdevError;
+    }
+
+    // Start with an empty shadow cache
+    gpio_shadow_init(&tera_shadow);
+
+    // Allocate the status page shared with user space
+    if (gpio_status_init(TERA_MAX_NODES))
+    {
+        printk("Status page can not be allocated!\n");
+        goto StatusError;
     }
 
     // Create device class
-    if (((teraData_st.my_class = class_create(DRIVER_CLASS)) == NULL))
+    teraData_st.my_class = class_create(DRIVER_CLASS);
+    if (IS_ERR(teraData_st.my_class))
     {
         printk("Device class can not be created!\n");
         goto ClassError;
     }
 
     // Register platform driver
-    platform_driver_register(&platform_driver_data);
+    if (!probe_async)
+    {
+        platform_driver_data.driver.probe_type = PROBE_FORCE_SYNCHRONOUS;
+    }
+    if (platform_driver_register(&platform_driver_data))
+    {
+        printk("Platform driver can not be registered!\n");
+        goto DriverError;
+    }
+
+    // Watch overlays adding or removing LED nodes at runtime
+    if (gpio_overlay_init(platDeviceIdDTS, tera_debugfs))
+    {
+        printk("Overlay notifier can not be registered!\n");
+        goto OverlayError;
+    }
     return 0;
 
+OverlayError:
+    platform_driver_unregister(&platform_driver_data);
+DriverError:
+    class_destroy(teraData_st.my_class);
 ClassError:
-    unregister_chrdev_region(teraData_st.my_device_nr, 1);
+    gpio_status_exit();
+StatusError:
+    cdev_del(&teraData_st.cdev_object);
+CdevError:
+    unregister_chrdev_region(teraData_st.my_device_nr, TERA_MAX_NODES);
+RegionError:
+    debugfs_remove(tera_debugfs);
     return -1;
 }
 
 // Deinitialization function for the kernel module
 static void __exit teraDEINIT(void)
 {
+    // Stop watching overlays and destroy the devices created for them
+    gpio_overlay_exit();
+
     // Unregister the platform driver
     platform_driver_unregister(&platform_driver_data);
 
     // Destroy the device class
     class_destroy(teraData_st.my_class);
 
+    // Free the status page
+    gpio_status_exit();
+
     /* Delete the character device object */
     cdev_del(&teraData_st.cdev_object);
 
      /* Unregister the device numbers */
-    unregister_chrdev_region(teraData_st.my_device_nr, 1);
+    unregister_chrdev_region(teraData_st.my_device_nr, TERA_MAX_NODES);
+
+    /* Remove the debugfs directory, the counters went away with their nodes */
+    debugfs_remove(tera_debugfs);
+
+    /* Every node is unbound, so every minor number is free again */
+    ida_destroy(&teraMinors);
 
     /* Print a goodbye message */
     printk("Goodbye from tera \n");
@@ -0,0 +1,220 @@
+/*
+ * Author: Eng. Mostafa Tera
+ * Date: 19/10/2026
+ */
+
+#ifndef TERA_GPIO_DT_UAPI
+#define TERA_GPIO_DT_UAPI
+
+/*
+ * This header is shared between the driver and user space programs, so it
+ * only depends on the exported kernel headers.
+ */
+#include <linux/types.h>
+#include <linux/ioctl.h>
+
+/*
+ * Edge types reported in tera_gpio_event.edge.
+ */
+#define TERA_GPIO_EDGE_FALLING 0
+#define TERA_GPIO_EDGE_RISING 1
+
+/*
+ * Struct: tera_gpio_event
+ * -----------------------
+ * One captured edge of an input pin, as returned by read() on the pin's
+ * device file.
+ */
+struct tera_gpio_event
+{
+    __u64 timestamp_ns; /* CLOCK_MONOTONIC time of the interrupt */
+    __u32 seqno;        /* Per-pin sequence number, gaps mean dropped events */
+    __u8 level;         /* Pin level read after the edge */
+    __u8 edge;          /* TERA_GPIO_EDGE_RISING or TERA_GPIO_EDGE_FALLING */
+    __u16 reserved;
+};
+
+/*
+ * Pin directions reported in the status page.
+ */
+#define TERA_GPIO_DIR_INPUT 0
+#define TERA_GPIO_DIR_OUTPUT 1
+
+/*
+ * TERA_GPIO_STATUS_MAX_PINS: Number of pin slots in the status page, one per
+ * minor number.
+ */
+#define TERA_GPIO_STATUS_MAX_PINS 256
+#define TERA_GPIO_STATUS_WORDS (TERA_GPIO_STATUS_MAX_PINS / 64)
+
+/*
+ * Struct: tera_gpio_status_pin
+ * ----------------------------
+ * State of one pin in the status page, indexed by minor number.
+ */
+struct tera_gpio_status_pin
+{
+    __u64 last_change_ns; /* CLOCK_MONOTONIC time of the last level or direction change */
+    __u32 changes;        /* Number of level or direction changes */
+    __u8 level;           /* Current level */
+    __u8 direction;       /* TERA_GPIO_DIR_INPUT or TERA_GPIO_DIR_OUTPUT */
+    __u16 reserved;
+};
+
+/*
+ * Struct: tera_gpio_status_page
+ * -----------------------------
+ * Read-only area returned by mmap() on any LED device file. It is larger
+ * than one 4 KiB page, so map sizeof(struct tera_gpio_status_page) rounded
+ * up to the page size. The driver updates it under a sequence count: seq is
+ * odd while an update is in progress, so a reader copies the area and
+ * retries until it read the same even seq before and after the copy. Bit N
+ * of a bitmap is pin N, in word N / 64 at bit N % 64.
+ */
+struct tera_gpio_status_page
+{
+    __u32 seq;                                /* Sequence count, odd during updates */
+    __u32 npins;                              /* Number of valid pin slots */
+    __u64 levels[TERA_GPIO_STATUS_WORDS];     /* Bit N = level of pin N */
+    __u64 directions[TERA_GPIO_STATUS_WORDS]; /* Bit N set = pin N is an output */
+    struct tera_gpio_status_pin pins[TERA_GPIO_STATUS_MAX_PINS];
+};
+
+/*
+ * TERA_GPIO_BULK_MAX_PINS: Number of nodes covered by the bulk state file,
+ * one per minor number.
+ */
+#define TERA_GPIO_BULK_MAX_PINS 256
+#define TERA_GPIO_BULK_WORDS (TERA_GPIO_BULK_MAX_PINS / 64)
+
+/*
+ * Struct: tera_gpio_bulk_state
+ * ----------------------------
+ * Snapshot returned by reading the state file of the driver,
+ * /sys/bus/platform/drivers/mydriver/state. Bit N of a bitmap is node N,
+ * the node with minor number N, in word N / 64 at bit N % 64.
+ */
+struct tera_gpio_bulk_state
+{
+    __u32 npins;                            /* Number of valid bits and counters */
+    __u32 reserved;
+    __u64 present[TERA_GPIO_BULK_WORDS];    /* Bit set: the node is probed */
+    __u64 directions[TERA_GPIO_BULK_WORDS]; /* Bit set: the node is an output */
+    __u64 levels[TERA_GPIO_BULK_WORDS];     /* Current level of every node */
+    __u32 changes[TERA_GPIO_BULK_MAX_PINS]; /* Level or direction changes of every node */
+};
+
+/*
+ * Struct: tera_gpio_bulk_update
+ * -----------------------------
+ * Written to the state file in one write() at offset 0: every node set in
+ * mask is driven to its bit of levels. All nodes in mask must be probed
+ * outputs, otherwise nothing is changed and the write fails with EINVAL.
+ */
+struct tera_gpio_bulk_update
+{
+    __u64 mask[TERA_GPIO_BULK_WORDS];
+    __u64 levels[TERA_GPIO_BULK_WORDS];
+};
+
+/*
+ * Read modes of an opened LED file, selected with TERA_GPIO_IOC_SET_READ_MODE.
+ * TERA_GPIO_READ_AUTO (the default) returns edge events while the pin
+ * captures them or some are left unread, and the level otherwise.
+ */
+#define TERA_GPIO_READ_AUTO 0
+#define TERA_GPIO_READ_LEVEL 1   /* "0\n" or "1\n" at offset 0, end of file after it */
+#define TERA_GPIO_READ_EVENTS 2  /* struct tera_gpio_event records of an input */
+#define TERA_GPIO_READ_SAMPLES 3 /* struct tera_gpio_sample records every period_us */
+#define TERA_GPIO_READ_BUFFER 4  /* Bytes of the last write, buff_size at most, from offset 0 */
+
+/*
+ * TERA_GPIO_SAMPLE_MIN_US: Shortest sampling period.
+ */
+#define TERA_GPIO_SAMPLE_MIN_US 100
+
+/*
+ * Struct: tera_gpio_sample
+ * ------------------------
+ * One level sample, as returned by read() in TERA_GPIO_READ_SAMPLES mode.
+ */
+struct tera_gpio_sample
+{
+    __u64 timestamp_ns; /* CLOCK_MONOTONIC time of the sample */
+    __u32 seqno;        /* Per-file sequence number, gaps mean dropped samples */
+    __u8 level;         /* Pin level */
+    __u8 reserved[3];
+};
+
+/*
+ * Struct: tera_gpio_read_mode
+ * ---------------------------
+ * Argument of TERA_GPIO_IOC_SET_READ_MODE. period_us is only used by
+ * TERA_GPIO_READ_SAMPLES and must be at least TERA_GPIO_SAMPLE_MIN_US.
+ */
+struct tera_gpio_read_mode
+{
+    __u32 mode;
+    __u32 period_us;
+};
+
+/*
+ * Struct: tera_gpio_state
+ * -----------------------
+ * Direction and level of the pin of a file, read as one consistent pair.
+ */
+struct tera_gpio_state
+{
+    __u32 direction; /* TERA_GPIO_DIR_INPUT or TERA_GPIO_DIR_OUTPUT */
+    __u32 level;
+};
+
+/*
+ * Struct: tera_gpio_bank
+ * ----------------------
+ * Argument of TERA_GPIO_IOC_SET_BANK. Bit I is pin I of the gpios property
+ * of the node: every pin set in mask is driven to its bit of values, the
+ * others keep their level.
+ */
+struct tera_gpio_bank
+{
+    __u32 mask;
+    __u32 values;
+};
+
+#define TERA_GPIO_IOC_MAGIC 't'
+
+/* Switch the pin of the file to TERA_GPIO_DIR_INPUT or TERA_GPIO_DIR_OUTPUT, needs write access */
+#define TERA_GPIO_IOC_SET_DIRECTION _IOW(TERA_GPIO_IOC_MAGIC, 0x40, __u32)
+
+/* Read the direction and level of the pin of the file */
+#define TERA_GPIO_IOC_GET_STATE _IOR(TERA_GPIO_IOC_MAGIC, 0x41, struct tera_gpio_state)
+
+/* Select what read() returns on this file */
+#define TERA_GPIO_IOC_SET_READ_MODE _IOW(TERA_GPIO_IOC_MAGIC, 0x42, struct tera_gpio_read_mode)
+
+/* Drive some pins of a bank at once, the node must be an output, needs write access */
+#define TERA_GPIO_IOC_SET_BANK _IOW(TERA_GPIO_IOC_MAGIC, 0x43, struct tera_gpio_bank)
+
+#ifndef __KERNEL__
+/*
+ * Function: tera_gpio_status_read
+ * -------------------------------
+ * Copies a consistent snapshot of a mapped status page without a syscall.
+ */
+static inline void tera_gpio_status_read(const volatile struct tera_gpio_status_page *page,
+                                         struct tera_gpio_status_page *snapshot)
+{
+    __u32 seq;
+
+    do
+    {
+        while ((seq = __atomic_load_n(&page->seq, __ATOMIC_ACQUIRE)) & 1)
+            ;
+        __builtin_memcpy(snapshot, (const void *)page, sizeof(*snapshot));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while (__atomic_load_n(&page->seq, __ATOMIC_RELAXED) != seq);
+}
+#endif
+
+#endif // !TERA_GPIO_DT_UAPI
@@ -0,0 +1,70 @@
+/*
+ * Author: Eng. Mostafa Tera
+ * Date: 19/10/2026
+ */
+
+#include "file_operations.h"
+#include "tera_led.h"
+
+/*
+ * Struct: tera_led
+ * ----------------
+ * LED class device of one node.
+ */
+struct tera_led
+{
+    struct led_classdev cdev;
+    struct tera_node *node; /* Node driven by the LED */
+};
+
+/*
+ * Function: tera_led_set
+ * ----------------------
+ * brightness_set_blocking callback. Goes through the shadow cache like the
+ * device file, so a trigger repeating the current level costs no GPIO access.
+ */
+static int tera_led_set(struct led_classdev *cdev, enum led_brightness brightness)
+{
+    struct tera_led *led = container_of(cdev, struct tera_led, cdev);
+
+    if (!gpio_shadow_is_output(&tera_shadow, led->node->index))
+    {
+        return -EBUSY; // The pin was switched to input through sysfs
+    }
+    gpio_shadow_set(&tera_shadow, led->node, brightness != LED_OFF);
+    return 0;
+}
+
+/*
+ * Function: tera_led_get
+ * ----------------------
+ * brightness_get callback.
+ */
+static enum led_brightness tera_led_get(struct led_classdev *cdev)
+{
+    struct tera_led *led = container_of(cdev, struct tera_led, cdev);
+
+    return gpio_shadow_get(&tera_shadow, led->node) > 0 ? LED_ON : LED_OFF;
+}
+
+int tera_led_register(struct device *dev, struct tera_node *node)
+{
+    struct tera_led *led;
+
+    led = devm_kzalloc(dev, sizeof(*led), GFP_KERNEL);
+    if (led == NULL)
+    {
+        return -ENOMEM;
+    }
+
+    led->node = node;
+    led->cdev.name = node->label;
+    led->cdev.max_brightness = LED_ON;
+    led->cdev.brightness_set_blocking = tera_led_set;
+    led->cdev.brightness_get = tera_led_get;
+
+    /* Optional trigger to attach at registration, e.g. "heartbeat" */
+    device_property_read_string(dev, "linux,default-trigger", &led->cdev.default_trigger);
+
+    return devm_led_classdev_register(dev, &led->cdev);
+}
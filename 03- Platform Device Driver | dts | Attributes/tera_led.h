@@ -0,0 +1,29 @@
+/*
+ * Author: Eng. Mostafa Tera
+ * Date: 19/10/2026
+ */
+
+#ifndef TERA_LED
+#define TERA_LED
+
+#include <linux/leds.h>
+
+struct tera_node;
+
+/*
+ * Function: tera_led_register
+ * ---------------------------
+ * Registers a LED node with the LED class, so in-kernel triggers (timer,
+ * heartbeat, netdev, disk-activity) can drive it without user space.
+ * The class device is device managed and goes away with the node.
+ *
+ * Parameters:
+ * - dev: The probed platform device.
+ * - node: State of the node, its label names the LED in /sys/class/leds.
+ *
+ * Returns:
+ * - 0 on success, otherwise an error code.
+ */
+int tera_led_register(struct device *dev, struct tera_node *node);
+
+#endif // !TERA_LED
@@ -0,0 +1,157 @@
+/*
+ * Author: Eng. Mostafa Tera
+ * Date: 19/10/2026
+ */
+
+#include "tera_props.h"
+
+/*
+ * Enum: tera_prop_type
+ * --------------------
+ * How a property of the schema is read.
+ */
+enum tera_prop_type
+{
+    TERA_PROP_STRING,    /* const char *, points into the fwnode */
+    TERA_PROP_U32,       /* One u32 cell */
+    TERA_PROP_U32_ARRAY, /* Up to max_count u32 cells, the count is stored at count */
+};
+
+/*
+ * Struct: tera_prop
+ * -----------------
+ * One entry of the schema of a LED node.
+ */
+struct tera_prop
+{
+    const char *name;         /* Property name */
+    enum tera_prop_type type;
+    size_t offset;            /* Field of struct tera_props */
+    size_t count;             /* Count field of a TERA_PROP_U32_ARRAY */
+    unsigned int max_count;   /* Size of the field of a TERA_PROP_U32_ARRAY */
+    bool required;            /* Probe fails without it, otherwise def is used */
+    u32 def;                  /* Default of an absent TERA_PROP_U32 */
+    u32 min, max;             /* Range of a TERA_PROP_U32 */
+};
+
+#define TERA_PROP_FIELD(field) offsetof(struct tera_props, field)
+
+/*
+ * Array: tera_schema
+ * ------------------
+ * Properties of a LED node. The pins of a node are not in the table: the
+ * GPIO core finds them in the gpios property, or the _CRS GPIO resources
+ * on ACPI, see tera_props_parse. Nodes without them give GPIO numbers in
+ * gpio_pin, several numbers make a bank like several gpios.
+ */
+static const struct tera_prop tera_schema[] = {
+    {.name = "label", .type = TERA_PROP_STRING, .offset = TERA_PROP_FIELD(label), .required = true},
+    {.name = "led_value", .type = TERA_PROP_U32, .offset = TERA_PROP_FIELD(led_value), .required = true, .max = 1},
+    {.name = "gpio_pin", .type = TERA_PROP_U32_ARRAY, .offset = TERA_PROP_FIELD(gpio_pin),
+     .count = TERA_PROP_FIELD(npins), .max_count = TERA_BANK_MAX_PINS},
+    {.name = "buff_size", .type = TERA_PROP_U32, .offset = TERA_PROP_FIELD(buff_size), .required = true,
+     .min = 1, .max = TERA_BUFF_SIZE_MAX},
+    {.name = "perm", .type = TERA_PROP_U32, .offset = TERA_PROP_FIELD(perm), .required = true,
+     .max = TERA_PERM_READ | TERA_PERM_WRITE},
+    {.name = "debounce_us", .type = TERA_PROP_U32, .offset = TERA_PROP_FIELD(debounce_us), .def = 0, .max = U32_MAX},
+};
+
+/*
+ * Function: tera_prop_read
+ * ------------------------
+ * Reads one property of the schema into props.
+ *
+ * Returns:
+ * - 0 when it was read, -EINVAL when it is absent, otherwise an error code.
+ */
+static int tera_prop_read(struct fwnode_handle *fwnode, const struct tera_prop *prop, struct tera_props *props)
+{
+    void *field = (char *)props + prop->offset;
+    int ret;
+
+    switch (prop->type)
+    {
+    case TERA_PROP_STRING:
+        return fwnode_property_read_string(fwnode, prop->name, field);
+    case TERA_PROP_U32:
+        return fwnode_property_read_u32(fwnode, prop->name, field);
+    case TERA_PROP_U32_ARRAY:
+        ret = fwnode_property_count_u32(fwnode, prop->name);
+        if (ret < 0)
+        {
+            return ret;
+        }
+        if (ret == 0 || ret > prop->max_count)
+        {
+            return -ERANGE;
+        }
+        *(unsigned int *)((char *)props + prop->count) = ret;
+        return fwnode_property_read_u32_array(fwnode, prop->name, field, ret);
+    }
+    return -EINVAL;
+}
+
+int tera_props_parse(struct device *dev, struct tera_props *props)
+{
+    struct fwnode_handle *fwnode = dev_fwnode(dev);
+    const struct tera_prop *prop;
+    int ret;
+
+    if (fwnode == NULL)
+    {
+        return dev_err_probe(dev, -ENODEV, "No firmware node\n");
+    }
+
+    memset(props, 0, sizeof(*props));
+    for (prop = tera_schema; prop < tera_schema + ARRAY_SIZE(tera_schema); prop++)
+    {
+        ret = tera_prop_read(fwnode, prop, props);
+        if (ret == -EINVAL && !prop->required)
+        {
+            if (prop->type == TERA_PROP_U32)
+            {
+                *(u32 *)((char *)props + prop->offset) = prop->def;
+            }
+            continue;
+        }
+        if (ret == -EINVAL)
+        {
+            return dev_err_probe(dev, ret, "Property '%s' not found\n", prop->name);
+        }
+        if (ret)
+        {
+            return dev_err_probe(dev, ret, "Invalid property '%s'\n", prop->name);
+        }
+        if (prop->type == TERA_PROP_U32)
+        {
+            u32 value = *(u32 *)((char *)props + prop->offset);
+
+            if (value < prop->min || value > prop->max)
+            {
+                return dev_err_probe(dev, -EINVAL, "'%s' is %u, must be %u..%u\n", prop->name, value, prop->min, prop->max);
+            }
+        }
+    }
+
+    if (props->perm & ~(TERA_PERM_READ | TERA_PERM_WRITE))
+    {
+        return dev_err_probe(dev, -EINVAL, "Unknown perm bits 0x%x\n", props->perm);
+    }
+
+    // Ask the GPIO core rather than look for a gpios property, ACPI lists the pins in _CRS
+    ret = gpiod_count(dev, NULL);
+    if (ret > TERA_BANK_MAX_PINS)
+    {
+        return dev_err_probe(dev, -EINVAL, "More than %d gpios\n", TERA_BANK_MAX_PINS);
+    }
+    props->ngpios = ret > 0 ? ret : 0;
+    if (props->ngpios == 0 && props->npins == 0)
+    {
+        return dev_err_probe(dev, -EINVAL, "No gpios and no 'gpio_pin' property\n");
+    }
+
+    dev_dbg(dev, "label %s led_value %u pins %u buff_size %u perm 0x%x debounce_us %u\n",
+            props->label, props->led_value, props->ngpios ? props->ngpios : props->npins,
+            props->buff_size, props->perm, props->debounce_us);
+    return 0;
+}
@@ -0,0 +1,47 @@
+/*
+ * Author: Eng. Mostafa Tera
+ * Date: 19/10/2026
+ */
+
+#ifndef TERA_PROPS
+#define TERA_PROPS
+
+#include "file_operations.h"
+
+/*
+ * Struct: tera_props
+ * ------------------
+ * Properties of one LED node, filled by tera_props_parse. Optional
+ * properties hold their default when the node does not give them.
+ */
+struct tera_props
+{
+    const char *label;                   /* label, name of the device file */
+    u32 led_value;                       /* led_value, initial level of the output */
+    unsigned int ngpios;                 /* Pins the GPIO core finds, gpios or ACPI _CRS, 0 for none */
+    u32 gpio_pin[TERA_BANK_MAX_PINS];    /* gpio_pin, GPIO numbers of the older bindings */
+    unsigned int npins;                  /* Entries of gpio_pin, 0 when the node uses gpios */
+    u32 buff_size;                       /* buff_size, largest write of the device file */
+    u32 perm;                            /* perm, TERA_PERM_READ and TERA_PERM_WRITE */
+    u32 debounce_us;                     /* debounce_us, optional settle time of the input */
+};
+
+/*
+ * Function: tera_props_parse
+ * --------------------------
+ * Reads every property of a LED node in one pass over a schema table:
+ * each property is looked up once, absent optional ones get their default
+ * and every value is checked against its range. The lookups go through
+ * the fwnode of the device, so DT, ACPI _DSD and software nodes are all
+ * parsed the same way.
+ *
+ * Parameters:
+ * - dev: The probed platform device.
+ * - props: Filled with the properties of the node.
+ *
+ * Returns:
+ * - 0 on success, otherwise an error code, reported with dev_err_probe.
+ */
+int tera_props_parse(struct device *dev, struct tera_props *props);
+
+#endif // !TERA_PROPS
@@ -0,0 +1,38 @@
+#!/bin/sh
+#
+# Author: Eng. Mostafa Tera
+# Date: 19/10/2026
+#
+# Compares benchmark results against a baseline.
+#
+# Both files hold CSV lines "test,param,metric,value" as printed by
+# tera_bench_user. Metrics ending in _ns regress when they grow, every
+# other metric regresses when it shrinks, by more than THRESHOLD percent.
+#
+# Usage: check_regression.sh <baseline.csv> <current.csv> [threshold %]
+# Exit status: 0 when nothing regressed, 1 otherwise.
+
+BASELINE=$1
+CURRENT=$2
+THRESHOLD=${3:-10}
+
+if [ ! -f "$BASELINE" ] || [ ! -f "$CURRENT" ]; then
+    echo "usage: $0 <baseline.csv> <current.csv> [threshold %]" >&2
+    exit 2
+fi
+
+awk -F, -v threshold="$THRESHOLD" '
+    NR == FNR { base[$1 "," $2 "," $3] = $4; next }
+    ($1 "," $2 "," $3) in base {
+        key = $1 "," $2 "," $3
+        old = base[key]
+        if (old == 0) next
+        change = ($4 - old) * 100 / old
+        worse = ($3 ~ /_ns$/) ? change > threshold : -change > threshold
+        printf "%-45s %14s %14s %+8.1f%% %s\n", key, old, $4, change, worse ? "REGRESSION" : "ok"
+        if (worse) failed++
+    }
+    END {
+        if (failed) { printf "%d regression(s) above %s%%\n", failed, threshold; exit 1 }
+    }
+' "$BASELINE" "$CURRENT"
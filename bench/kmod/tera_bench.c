@@ -0,0 +1,437 @@
+/*
+ * Author: Eng. Mostafa Tera
+ * Date: 19/10/2026
+ */
+
+#include <linux/init.h>
+#include <linux/module.h>
+#include <linux/fs.h>
+#include <linux/kthread.h>
+#include <linux/slab.h>
+#include <linux/seq_file.h>
+#include <linux/completion.h>
+#include <linux/cpumask.h>
+#include <linux/sizes.h>
+#include "../../common/tera_core.h"
+
+MODULE_LICENSE("GPL");
+MODULE_AUTHOR("MOSTAFA TERA");
+MODULE_DESCRIPTION("In-kernel benchmark of the tera device files");
+
+/*
+ * TERA_BENCH_RESULTS: Size of the text kept for the results file.
+ */
+#define TERA_BENCH_RESULTS 4096
+
+/*
+ * Enum: tera_bench_op
+ * -------------------
+ * Workload of every benchmark thread.
+ */
+enum tera_bench_op
+{
+    TERA_BENCH_WRITE, /* kernel_write() only */
+    TERA_BENCH_READ,  /* kernel_read() only */
+    TERA_BENCH_RW     /* kernel_write() then kernel_read() of the same size */
+};
+
+static const char *const tera_bench_ops[] = {
+    [TERA_BENCH_WRITE] = "write",
+    [TERA_BENCH_READ] = "read",
+    [TERA_BENCH_RW] = "rw",
+};
+
+/*
+ * Struct: tera_bench_config
+ * -------------------------
+ * Workload of one run, copied before the threads start so debugfs writes
+ * during a run do not change it.
+ */
+struct tera_bench_config
+{
+    char device[64];            /* Device file opened by every thread */
+    enum tera_bench_op op;
+    u32 size;                   /* Bytes per call */
+    u32 iterations;             /* Calls per thread */
+};
+
+/*
+ * Struct: tera_bench
+ * ------------------
+ * Configuration set through debugfs and the results of the last run.
+ */
+static struct tera_bench
+{
+    struct mutex lock;          /* One run at a time, protects device, op and results */
+    char device[64];
+    enum tera_bench_op op;
+    u32 size;
+    u32 iterations;
+    u32 threads;                /* Largest thread count of the sweep, 0 = online CPUs */
+    char results[TERA_BENCH_RESULTS];
+    struct dentry *dir;
+} bench = {
+    .device = "/dev/teraDriver",
+    .op = TERA_BENCH_RW,
+    .size = 64,
+    .iterations = 100000,
+};
+
+/*
+ * Struct: tera_bench_thread
+ * -------------------------
+ * State of one benchmark kthread.
+ */
+struct tera_bench_thread
+{
+    const struct tera_bench_config *cfg;
+    struct completion *start;   /* Released once every thread is ready */
+    struct completion done;
+    u64 ns;                     /* Time spent in the loop */
+    u64 ops;                    /* Successful calls */
+    u64 bytes;
+    u64 errors;
+    int ret;                    /* Error of filp_open, if any */
+};
+
+/*
+ * Function: tera_bench_thread_fn
+ * ------------------------------
+ * Opens the device and runs the configured calls on it.
+ */
+static int tera_bench_thread_fn(void *data)
+{
+    struct tera_bench_thread *t = data;
+    const struct tera_bench_config *cfg = t->cfg;
+    struct file *file;
+    char *buf;
+    u64 start;
+    u32 i;
+
+    buf = kmalloc(cfg->size, GFP_KERNEL);
+    if (buf == NULL)
+    {
+        t->ret = -ENOMEM;
+        wait_for_completion(t->start);
+        goto out;
+    }
+    file = filp_open(cfg->device, cfg->op == TERA_BENCH_WRITE ? O_WRONLY : O_RDWR, 0);
+    if (IS_ERR(file))
+    {
+        t->ret = PTR_ERR(file);
+        wait_for_completion(t->start);
+        goto out;
+    }
+
+    /* "10" toggles a LED on the GPIO devices and is plain data for the char device */
+    for (i = 0; i < cfg->size; i++)
+    {
+        buf[i] = i & 1 ? '0' : '1';
+    }
+
+    wait_for_completion(t->start);
+    start = ktime_get_ns();
+
+    for (i = 0; i < cfg->iterations; i++)
+    {
+        loff_t pos = 0;
+        ssize_t ret;
+
+        if (cfg->op != TERA_BENCH_READ)
+        {
+            ret = kernel_write(file, buf, cfg->size, &pos);
+            if (ret < 0)
+            {
+                t->errors++;
+            }
+            else
+            {
+                t->ops++;
+                t->bytes += ret;
+            }
+        }
+        if (cfg->op != TERA_BENCH_WRITE)
+        {
+            pos = 0;
+            ret = kernel_read(file, buf, cfg->size, &pos);
+            if (ret < 0)
+            {
+                t->errors++;
+            }
+            else
+            {
+                t->ops++;
+                t->bytes += ret;
+            }
+        }
+    }
+
+    t->ns = ktime_get_ns() - start;
+    filp_close(file, NULL);
+out:
+    kfree(buf);
+    complete(&t->done);
+    return 0;
+}
+
+/*
+ * Function: tera_bench_run_threads
+ * --------------------------------
+ * Runs nthreads kthreads, one per CPU as far as there are CPUs, and appends
+ * one result line. Called with bench.lock held.
+ *
+ * Returns:
+ * - Aggregate calls per second, 0 when the run failed.
+ */
+static u64 tera_bench_run_threads(const struct tera_bench_config *cfg, u32 nthreads, u64 base_rate, size_t *len)
+{
+    struct tera_bench_thread *threads;
+    DECLARE_COMPLETION_ONSTACK(start);
+    u64 wall, ops = 0, bytes = 0, errors = 0, thread_ns = 0, rate, scaling;
+    int ret = 0;
+    u32 i;
+
+    threads = kcalloc(nthreads, sizeof(*threads), GFP_KERNEL);
+    if (threads == NULL)
+    {
+        return 0;
+    }
+
+    for (i = 0; i < nthreads; i++)
+    {
+        struct task_struct *task;
+
+        threads[i].cfg = cfg;
+        threads[i].start = &start;
+        init_completion(&threads[i].done);
+        task = kthread_create(tera_bench_thread_fn, &threads[i], "tera_bench/%u", i);
+        if (IS_ERR(task))
+        {
+            ret = PTR_ERR(task);
+            nthreads = i; // Run with the threads created so far, then report the failure
+            break;
+        }
+        kthread_bind(task, cpumask_local_spread(i, NUMA_NO_NODE));
+        wake_up_process(task);
+    }
+
+    wall = ktime_get_ns();
+    complete_all(&start);
+    for (i = 0; i < nthreads; i++)
+    {
+        wait_for_completion(&threads[i].done);
+    }
+    wall = ktime_get_ns() - wall;
+
+    for (i = 0; i < nthreads; i++)
+    {
+        if (threads[i].ret)
+        {
+            ret = threads[i].ret;
+        }
+        ops += threads[i].ops;
+        bytes += threads[i].bytes;
+        errors += threads[i].errors;
+        thread_ns += threads[i].ns;
+    }
+    kfree(threads);
+
+    if (ret || ops == 0 || wall == 0)
+    {
+        *len += scnprintf(bench.results + *len, TERA_BENCH_RESULTS - *len,
+                          "%u 0 0 0 0 %llu # error %d\n", nthreads, errors, ret);
+        return 0;
+    }
+
+    /* ns/op is the cost seen by one thread, rate and bytes/s are for the whole run */
+    rate = div64_u64(ops * NSEC_PER_SEC, wall);
+    scaling = div64_u64(rate * 100, base_rate ? base_rate : rate); // In hundredths
+    *len += scnprintf(bench.results + *len, TERA_BENCH_RESULTS - *len,
+                      "%u %llu %llu %llu %llu.%02llu %llu\n", nthreads,
+                      div64_u64(thread_ns, ops), rate, div64_u64(bytes * NSEC_PER_SEC, wall),
+                      scaling / 100, scaling % 100, errors);
+    return rate;
+}
+
+/*
+ * Function: tera_bench_run
+ * ------------------------
+ * Runs the sweep 1, 2, 4, ... threads up to bench.threads and replaces the
+ * results. Called with bench.lock held.
+ *
+ * Returns:
+ * - 0 on success, -EINVAL for an invalid size or iteration count.
+ */
+static int tera_bench_run(void)
+{
+    u32 max = READ_ONCE(bench.threads) ? READ_ONCE(bench.threads) : num_online_cpus();
+    struct tera_bench_config cfg = {
+        .op = bench.op,
+        .size = READ_ONCE(bench.size),
+        .iterations = READ_ONCE(bench.iterations),
+    };
+    u64 base = 0, rate;
+    size_t len;
+    u32 n;
+
+    if (cfg.size == 0 || cfg.size > SZ_1M || cfg.iterations == 0)
+    {
+        return -EINVAL;
+    }
+
+    strscpy(cfg.device, bench.device, sizeof(cfg.device));
+    len = scnprintf(bench.results, TERA_BENCH_RESULTS, "# device=%s op=%s size=%u iterations=%u\n"
+                    "# threads ns_per_op ops_per_sec bytes_per_sec scaling errors\n",
+                    cfg.device, tera_bench_ops[cfg.op], cfg.size, cfg.iterations);
+
+    for (n = 1;; n = min(n * 2, max))
+    {
+        rate = tera_bench_run_threads(&cfg, n, base, &len);
+        if (n == 1)
+        {
+            base = rate;
+        }
+        if (n >= max)
+        {
+            break;
+        }
+    }
+    return 0;
+}
+
+static ssize_t tera_bench_run_write(struct file *file, const char __user *buf, size_t count, loff_t *ppos)
+{
+    int ret;
+
+    mutex_lock(&bench.lock);
+    ret = tera_bench_run();
+    mutex_unlock(&bench.lock);
+    return ret ? ret : count;
+}
+
+static const struct file_operations tera_bench_run_fops = {
+    .owner = THIS_MODULE,
+    .write = tera_bench_run_write,
+};
+
+static int tera_bench_results_show(struct seq_file *s, void *unused)
+{
+    mutex_lock(&bench.lock);
+    seq_puts(s, bench.results);
+    mutex_unlock(&bench.lock);
+    return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(tera_bench_results);
+
+static int tera_bench_device_show(struct seq_file *s, void *unused)
+{
+    mutex_lock(&bench.lock);
+    seq_printf(s, "%s\n", bench.device);
+    mutex_unlock(&bench.lock);
+    return 0;
+}
+
+static int tera_bench_device_open(struct inode *inode, struct file *file)
+{
+    return single_open(file, tera_bench_device_show, NULL);
+}
+
+static ssize_t tera_bench_device_write(struct file *file, const char __user *buf, size_t count, loff_t *ppos)
+{
+    char device[sizeof(bench.device)];
+
+    if (count == 0 || count >= sizeof(device))
+    {
+        return -EINVAL;
+    }
+    if (copy_from_user(device, buf, count))
+    {
+        return -EFAULT;
+    }
+    device[count] = '\0';
+
+    mutex_lock(&bench.lock);
+    strscpy(bench.device, strim(device), sizeof(bench.device));
+    mutex_unlock(&bench.lock);
+    return count;
+}
+
+static const struct file_operations tera_bench_device_fops = {
+    .owner = THIS_MODULE,
+    .open = tera_bench_device_open,
+    .read = seq_read,
+    .write = tera_bench_device_write,
+    .llseek = seq_lseek,
+    .release = single_release,
+};
+
+static int tera_bench_op_show(struct seq_file *s, void *unused)
+{
+    seq_printf(s, "%s\n", tera_bench_ops[READ_ONCE(bench.op)]);
+    return 0;
+}
+
+static int tera_bench_op_open(struct inode *inode, struct file *file)
+{
+    return single_open(file, tera_bench_op_show, NULL);
+}
+
+static ssize_t tera_bench_op_write(struct file *file, const char __user *buf, size_t count, loff_t *ppos)
+{
+    char op[8];
+    int ret;
+
+    if (count == 0 || count >= sizeof(op))
+    {
+        return -EINVAL;
+    }
+    if (copy_from_user(op, buf, count))
+    {
+        return -EFAULT;
+    }
+    op[count] = '\0';
+
+    ret = sysfs_match_string(tera_bench_ops, op);
+    if (ret < 0)
+    {
+        return ret;
+    }
+
+    mutex_lock(&bench.lock);
+    bench.op = ret;
+    mutex_unlock(&bench.lock);
+    return count;
+}
+
+static const struct file_operations tera_bench_op_fops = {
+    .owner = THIS_MODULE,
+    .open = tera_bench_op_open,
+    .read = seq_read,
+    .write = tera_bench_op_write,
+    .llseek = seq_lseek,
+    .release = single_release,
+};
+
+static int __init tera_bench_init(void)
+{
+    mutex_init(&bench.lock);
+    strscpy(bench.results, "# not run yet, write 1 to run\n", sizeof(bench.results));
+
+    bench.dir = debugfs_create_dir("bench", tera_core_debugfs_root());
+    debugfs_create_file("device", 0600, bench.dir, NULL, &tera_bench_device_fops);
+    debugfs_create_file("op", 0600, bench.dir, NULL, &tera_bench_op_fops);
+    debugfs_create_u32("size", 0600, bench.dir, &bench.size);
+    debugfs_create_u32("iterations", 0600, bench.dir, &bench.iterations);
+    debugfs_create_u32("threads", 0600, bench.dir, &bench.threads);
+    debugfs_create_file("run", 0200, bench.dir, NULL, &tera_bench_run_fops);
+    debugfs_create_file("results", 0400, bench.dir, NULL, &tera_bench_results_fops);
+    return 0;
+}
+
+static void __exit tera_bench_exit(void)
+{
+    debugfs_remove(bench.dir);
+}
+
+module_init(tera_bench_init);
+module_exit(tera_bench_exit);
@@ -0,0 +1,242 @@
+/*
+ * Author: Eng. Mostafa Tera
+ * Date: 19/10/2026
+ */
+
+#include <linux/init.h>
+#include <linux/module.h>
+#include <linux/platform_device.h>
+#include <linux/property.h>
+#include <linux/slab.h>
+#include <linux/seq_file.h>
+#include <linux/mm.h>
+#include "../../common/tera_core.h"
+
+MODULE_LICENSE("GPL");
+MODULE_AUTHOR("MOSTAFA TERA");
+MODULE_DESCRIPTION("Probe scaling harness of the DT LED driver with software nodes");
+
+/*
+ * TERA_SWNODE_RESULTS: Size of the text kept for the results file.
+ */
+#define TERA_SWNODE_RESULTS 4096
+
+/*
+ * TERA_SWNODE_DRIVER: Name of the platform driver of the 03 module. Devices
+ * with this name and no of_node bind to it by name.
+ */
+#define TERA_SWNODE_DRIVER "mydriver"
+
+/*
+ * TERA_SWNODE_MAX_NODES: Largest sweep. The 03 driver has 256 minor numbers
+ * (TERA_MAX_NODES, one per bit of its shadow and status page), so probe of
+ * more devices fails and their timings would say nothing. Scaling beyond
+ * this count is not measured.
+ */
+#define TERA_SWNODE_MAX_NODES 256
+
+/*
+ * Struct: tera_swnode
+ * -------------------
+ * Configuration set through debugfs and the results of the last run.
+ */
+static struct tera_swnode
+{
+    struct mutex lock;          /* One run at a time, protects results */
+    u32 nodes;                  /* Largest number of devices of the sweep */
+    u32 gpio_base;              /* First GPIO number of the gpio-sim chip, node N uses gpio_base + N */
+    char results[TERA_SWNODE_RESULTS];
+    struct dentry *dir;
+} swnode = {
+    .nodes = 64,
+};
+
+/*
+ * Function: tera_swnode_register
+ * ------------------------------
+ * Creates one platform device carrying the properties of a DT LED node as
+ * a software node. The software node is device managed and goes away with
+ * the device.
+ */
+static struct platform_device *tera_swnode_register(u32 index)
+{
+    struct platform_device *pdev;
+    char label[16];
+    struct property_entry props[] = {
+        PROPERTY_ENTRY_STRING("label", label),
+        PROPERTY_ENTRY_U32("led_value", 0),
+        PROPERTY_ENTRY_U32("gpio_pin", swnode.gpio_base + index),
+        PROPERTY_ENTRY_U32("buff_size", 3),
+        PROPERTY_ENTRY_U32("perm", 0x11),
+        {}
+    };
+    struct platform_device_info info = {
+        .name = TERA_SWNODE_DRIVER,
+        .id = index,
+        .properties = props, // Copied, strings included
+    };
+
+    snprintf(label, sizeof(label), "tera_sw%u", index);
+    pdev = platform_device_register_full(&info);
+    return pdev;
+}
+
+/*
+ * Function: tera_swnode_free_bytes
+ * --------------------------------
+ * Free memory of the system, for the memory cost per device.
+ */
+static s64 tera_swnode_free_bytes(void)
+{
+    struct sysinfo info;
+
+    si_meminfo(&info);
+    return (s64)info.freeram * info.mem_unit;
+}
+
+/*
+ * Function: tera_swnode_run_nodes
+ * -------------------------------
+ * Registers n devices, waits until every probe finished, then unregisters
+ * them again, and appends one result line. Called with swnode.lock held.
+ */
+static void tera_swnode_run_nodes(u32 n, size_t *len)
+{
+    struct platform_device **pdevs;
+    u64 probe_ns, remove_ns;
+    s64 mem;
+    u32 i, created = 0, bound = 0;
+    int ret = 0;
+
+    pdevs = kcalloc(n, sizeof(*pdevs), GFP_KERNEL);
+    if (pdevs == NULL)
+    {
+        *len += scnprintf(swnode.results + *len, TERA_SWNODE_RESULTS - *len,
+                          "%u 0 0 0 0 # error %d\n", n, -ENOMEM);
+        return;
+    }
+
+    mem = tera_swnode_free_bytes();
+    probe_ns = ktime_get_ns();
+    for (i = 0; i < n; i++)
+    {
+        pdevs[i] = tera_swnode_register(i);
+        if (IS_ERR(pdevs[i]))
+        {
+            ret = PTR_ERR(pdevs[i]);
+            break;
+        }
+        created++;
+    }
+    wait_for_device_probe(); // Asynchronous probes included
+    probe_ns = ktime_get_ns() - probe_ns;
+    mem -= tera_swnode_free_bytes();
+
+    for (i = 0; i < created; i++)
+    {
+        if (READ_ONCE(pdevs[i]->dev.driver))
+        {
+            bound++;
+        }
+    }
+
+    remove_ns = ktime_get_ns();
+    for (i = 0; i < created; i++)
+    {
+        platform_device_unregister(pdevs[i]);
+    }
+    remove_ns = ktime_get_ns() - remove_ns;
+    kfree(pdevs);
+
+    if (created == 0)
+    {
+        *len += scnprintf(swnode.results + *len, TERA_SWNODE_RESULTS - *len,
+                          "%u 0 0 0 0 # error %d\n", n, ret);
+        return;
+    }
+    *len += scnprintf(swnode.results + *len, TERA_SWNODE_RESULTS - *len,
+                      "%u %u %llu %llu %lld%s\n", n, bound,
+                      div64_u64(probe_ns, created), div64_u64(remove_ns, created),
+                      div64_s64(mem, created), bound < n ? " # not every device bound" : "");
+}
+
+/*
+ * Function: tera_swnode_run
+ * -------------------------
+ * Runs the sweep 1, 2, 4, ... devices up to swnode.nodes and replaces the
+ * results. Called with swnode.lock held.
+ *
+ * Returns:
+ * - 0 on success, -EINVAL for a node count of 0 or above
+ *   TERA_SWNODE_MAX_NODES.
+ */
+static int tera_swnode_run(void)
+{
+    u32 max = READ_ONCE(swnode.nodes);
+    size_t len;
+    u32 n;
+
+    if (max == 0 || max > TERA_SWNODE_MAX_NODES)
+    {
+        return -EINVAL;
+    }
+
+    len = scnprintf(swnode.results, TERA_SWNODE_RESULTS, "# gpio_base=%u\n"
+                    "# nodes bound probe_ns_per_node remove_ns_per_node bytes_per_node\n",
+                    READ_ONCE(swnode.gpio_base));
+
+    for (n = 1;; n = min(n * 2, max))
+    {
+        tera_swnode_run_nodes(n, &len);
+        if (n >= max)
+        {
+            break;
+        }
+    }
+    return 0;
+}
+
+static ssize_t tera_swnode_run_write(struct file *file, const char __user *buf, size_t count, loff_t *ppos)
+{
+    int ret;
+
+    mutex_lock(&swnode.lock);
+    ret = tera_swnode_run();
+    mutex_unlock(&swnode.lock);
+    return ret ? ret : count;
+}
+
+static const struct file_operations tera_swnode_run_fops = {
+    .owner = THIS_MODULE,
+    .write = tera_swnode_run_write,
+};
+
+static int tera_swnode_results_show(struct seq_file *s, void *unused)
+{
+    mutex_lock(&swnode.lock);
+    seq_puts(s, swnode.results);
+    mutex_unlock(&swnode.lock);
+    return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(tera_swnode_results);
+
+static int __init tera_swnode_init(void)
+{
+    mutex_init(&swnode.lock);
+    strscpy(swnode.results, "# not run yet, write 1 to run\n", sizeof(swnode.results));
+
+    swnode.dir = debugfs_create_dir("swnode", tera_core_debugfs_root());
+    debugfs_create_u32("nodes", 0600, swnode.dir, &swnode.nodes);
+    debugfs_create_u32("gpio_base", 0600, swnode.dir, &swnode.gpio_base);
+    debugfs_create_file("run", 0200, swnode.dir, NULL, &tera_swnode_run_fops);
+    debugfs_create_file("results", 0400, swnode.dir, NULL, &tera_swnode_results_fops);
+    return 0;
+}
+
+static void __exit tera_swnode_exit(void)
+{
+    debugfs_remove(swnode.dir);
+}
+
+module_init(tera_swnode_init);
+module_exit(tera_swnode_exit);
@@ -0,0 +1,167 @@
+#!/bin/sh
+#
+# Author: Eng. Mostafa Tera
+# Date: 19/10/2026
+#
+# Measures a device tree overlay apply/remove cycle of the DT LED driver
+# (03-) for 1, 2, 4 ... N nodes.
+#
+# Every node is a tera,gpio-led node on a line of a gpio-sim chip, so no
+# board is needed. The kernel needs CONFIG_OF_OVERLAY and the configfs
+# overlay interface (/sys/kernel/config/device-tree/overlays). That
+# interface is not in mainline Linux: it is an out-of-tree patch carried by
+# the Raspberry Pi kernel (CONFIG_OF_CONFIGFS), so on other kernels the
+# script stops right away. dtc must be installed and teraGPIO.ko must
+# already be loaded.
+#
+# Usage: overlay_time.sh <max nodes> [runs]
+# Output: CSV lines "nodes,run,apply_us,remove_us,kernel_apply_us,kernel_remove_us"
+# on stdout. apply_us and remove_us run until every node is bound or
+# unbound, polled every millisecond. The kernel_ columns come from the driver's overlay notifier and
+# cover only the overlay change itself, they are empty without debugfs.
+
+set -e
+
+MAX=$1
+RUNS=${2:-5}
+DRIVER=/sys/bus/platform/drivers/mydriver
+SIM=/sys/kernel/config/gpio-sim/tera_overlay
+OVERLAYS=/sys/kernel/config/device-tree/overlays
+STATS=/sys/kernel/debug/tera/teraGPIO_dt/overlay
+WORK=$(mktemp -d)
+
+if [ -z "$MAX" ]; then
+    echo "usage: $0 <max nodes> [runs]" >&2
+    exit 1
+fi
+if [ ! -d "$DRIVER" ]; then
+    echo "load teraGPIO.ko first" >&2
+    exit 1
+fi
+if [ ! -d "$OVERLAYS" ]; then
+    echo "no configfs overlay interface in $OVERLAYS" >&2
+    echo "it needs a kernel with the out-of-tree CONFIG_OF_CONFIGFS patch, e.g. the Raspberry Pi kernel" >&2
+    exit 1
+fi
+
+# Create a simulated GPIO chip with one line per node
+setup_sim() {
+    modprobe gpio-sim
+    mountpoint -q /sys/kernel/config || mount -t configfs none /sys/kernel/config
+    mkdir -p "$SIM/bank0"
+    echo "$MAX" > "$SIM/bank0/num_lines"
+    echo tera_overlay > "$SIM/bank0/label"
+    echo 1 > "$SIM/live"
+}
+
+cleanup() {
+    for ovl in "$OVERLAYS"/tera_*; do
+        [ -d "$ovl" ] && rmdir "$ovl"
+    done
+    if [ -d "$SIM" ]; then
+        echo 0 > "$SIM/live"
+        rmdir "$SIM/bank0" "$SIM"
+    fi
+    rm -rf "$WORK"
+}
+
+# First GPIO number of the simulated chip, the nodes use gpio_pin. Read
+# from the debugfs summary ("gpiochipN: GPIOs A-B, ..."), so the legacy
+# /sys/class/gpio interface is not needed.
+gpio_base() {
+    if [ -n "$GPIO_BASE" ]; then
+        echo "$GPIO_BASE"
+        return
+    fi
+    chip=$(cat "$SIM/bank0/chip_name")
+    mountpoint -q /sys/kernel/debug || mount -t debugfs none /sys/kernel/debug
+    base=$(sed -n "s/^$chip: GPIOs \([0-9]*\)-.*/\1/p" /sys/kernel/debug/gpio 2>/dev/null)
+    if [ -z "$base" ]; then
+        echo "can not find $chip in /sys/kernel/debug/gpio, set GPIO_BASE" >&2
+        exit 1
+    fi
+    echo "$base"
+}
+
+# Overlay with $1 LED nodes
+make_overlay() {
+    {
+        echo "/dts-v1/;"
+        echo "/plugin/;"
+        echo "/ { fragment@0 { target-path = \"/\"; __overlay__ {"
+        i=0
+        while [ "$i" -lt "$1" ]; do
+            echo "tera_ovl$i { compatible = \"tera,gpio-led\"; status = \"okay\";"
+            echo "    label = \"tera_ovl$i\"; led_value = <0>; gpio_pin = <$((BASE + i))>;"
+            echo "    buff_size = <3>; perm = <0x11>; };"
+            i=$((i + 1))
+        done
+        echo "}; }; };"
+    } > "$WORK/tera_$1.dts"
+    dtc -@ -q -I dts -O dtb -o "$WORK/tera_$1.dtbo" "$WORK/tera_$1.dts"
+}
+
+# Number of overlay nodes currently bound to the driver, counted with a
+# glob so the polling loop does not fork
+bound() {
+    set -- "$DRIVER"/*tera_ovl*
+    if [ -e "$1" ]; then
+        echo $#
+    else
+        echo 0
+    fi
+}
+
+now_us() {
+    echo $(( $(date +%s%N) / 1000 ))
+}
+
+# Waits until bound() returns $1, at most 10 s
+wait_bound() {
+    start=$1
+    while [ "$(bound)" -ne "$2" ]; do
+        if [ $(( $(now_us) - start )) -gt 10000000 ]; then
+            echo "$(bound) nodes bound after 10 s, expected $2" >&2
+            exit 1
+        fi
+        sleep 0.001
+    done
+}
+
+# Value of a counter in the debugfs overlay file, in us
+kernel_us() {
+    if [ -r "$STATS" ]; then
+        echo $(( $(awk -v key="$1" '$1 == key { print $2 }' "$STATS") / 1000 ))
+    fi
+}
+
+trap cleanup EXIT
+setup_sim
+BASE=$(gpio_base)
+
+n=1
+while :; do
+    make_overlay "$n"
+    run=1
+    while [ "$run" -le "$RUNS" ]; do
+        mkdir "$OVERLAYS/tera_$n"
+        start=$(now_us)
+        cat "$WORK/tera_$n.dtbo" > "$OVERLAYS/tera_$n/dtbo"
+        wait_bound "$start" "$n"
+        apply=$(( $(now_us) - start ))
+        kapply=$(kernel_us last_apply_ns)
+
+        start=$(now_us)
+        rmdir "$OVERLAYS/tera_$n"
+        wait_bound "$start" 0
+        remove=$(( $(now_us) - start ))
+        kremove=$(kernel_us last_remove_ns)
+
+        echo "$n,$run,$apply,$remove,$kapply,$kremove"
+        run=$((run + 1))
+    done
+
+    [ "$n" -ge "$MAX" ] && break
+    n=$((n * 2))
+    [ "$n" -gt "$MAX" ] && n=$MAX
+done
@@ -0,0 +1,105 @@
+#!/bin/sh
+#
+# Author: Eng. Mostafa Tera
+# Date: 19/10/2026
+#
+# Compares serial and asynchronous bring-up of the LED platform driver.
+#
+# The GPIO lines come from a gpio-sim chip, so no board is needed. The LED
+# nodes themselves must already exist (device tree overlay or platform
+# device modules) and use pins of that chip. The chip gets a dynamic GPIO
+# base, the script looks it up and hands it to the 02 driver as gpio_base=
+# (the 03 driver takes its pins from the device tree and needs nothing).
+#
+# Usage: probe_time.sh <module.ko> <expected nodes> [runs]
+# Output: CSV lines "mode,run,usec" on stdout.
+
+set -e
+
+MODULE=$1
+NODES=$2
+RUNS=${3:-10}
+DRIVER=/sys/bus/platform/drivers/mydriver
+SIM=/sys/kernel/config/gpio-sim/tera_probe
+
+if [ -z "$MODULE" ] || [ -z "$NODES" ]; then
+    echo "usage: $0 <module.ko> <expected nodes> [runs]" >&2
+    exit 1
+fi
+
+# Create a simulated GPIO chip with one line per node
+setup_sim() {
+    modprobe gpio-sim
+    mountpoint -q /sys/kernel/config || mount -t configfs none /sys/kernel/config
+    mkdir -p "$SIM/bank0"
+    echo "$NODES" > "$SIM/bank0/num_lines"
+    echo tera_probe > "$SIM/bank0/label"
+    echo 1 > "$SIM/live"
+    echo "gpio-sim chip: $(cat "$SIM/bank0/chip_name"), base $(sim_base)" >&2
+}
+
+# Global GPIO number of line 0 of the simulated chip, from the debugfs
+# summary ("gpiochipN: GPIOs A-B, ...") or else the legacy sysfs class
+sim_base() {
+    chip=$(cat "$SIM/bank0/chip_name")
+    mountpoint -q /sys/kernel/debug || mount -t debugfs none /sys/kernel/debug
+    base=$(sed -n "s/^$chip: GPIOs \([0-9]*\)-.*/\1/p" /sys/kernel/debug/gpio 2>/dev/null)
+    if [ -z "$base" ]; then
+        for c in /sys/class/gpio/gpiochip*; do
+            if [ "$(cat "$c/label" 2>/dev/null)" = tera_probe ]; then
+                base=$(cat "$c/base")
+            fi
+        done
+    fi
+    if [ -z "$base" ]; then
+        echo "can not find the GPIO base of $chip" >&2
+        exit 1
+    fi
+    echo "$base"
+}
+
+# Module parameters pointing the driver at the simulated chip
+module_args() {
+    if modinfo -p "$MODULE" | grep -q '^gpio_base:'; then
+        echo "gpio_base=$(sim_base)"
+    fi
+}
+
+cleanup_sim() {
+    rmmod "$(basename "$MODULE" .ko)" 2>/dev/null || true
+    if [ -d "$SIM" ]; then
+        echo 0 > "$SIM/live"
+        rmdir "$SIM/bank0" "$SIM"
+    fi
+}
+
+# Number of LED nodes currently bound to the driver
+bound() {
+    ls "$DRIVER" 2>/dev/null | grep -vc -e bind -e uevent -e module || true
+}
+
+now_us() {
+    echo $(( $(date +%s%N) / 1000 ))
+}
+
+trap cleanup_sim EXIT
+setup_sim
+ARGS=$(module_args)
+
+for mode in 0 1; do
+    run=1
+    while [ "$run" -le "$RUNS" ]; do
+        start=$(now_us)
+        insmod "$MODULE" probe_async="$mode" $ARGS
+        while [ "$(bound)" -lt "$NODES" ]; do
+            if [ $(( $(now_us) - start )) -gt 10000000 ]; then
+                echo "only $(bound) of $NODES nodes bound after 10 s" >&2
+                exit 1
+            fi
+        done
+        end=$(now_us)
+        echo "$( [ "$mode" = 1 ] && echo async || echo serial ),$run,$((end - start))"
+        rmmod "$(basename "$MODULE" .ko)"
+        run=$((run + 1))
+    done
+done
@@ -0,0 +1,586 @@
+/*
+ * Author: Eng. Mostafa Tera
+ * Date: 19/10/2026
+ *
+ * User space benchmarks of the tera device files. Every result is printed
+ * as one CSV line "test,param,metric,value" so runs can be compared by
+ * check_regression.sh. Metrics ending in _ns are lower-is-better, every
+ * other metric is higher-is-better.
+ *
+ * Usage: tera_bench_user <test> [options]
+ *   blocksize  write+read pairs on the char device for 1..max bytes
+ *   threads    write+read pairs of -b bytes with 1..-n threads
+ *   churn      open/close of the device file
+ *   poll       wakeup latency of poll() on an input pin, edges made by
+ *              writing the gpio-sim pull file given with -p
+ *   toggle     LED toggles per second, text and binary protocol
+ *   state      TERA_GPIO_IOC_GET_STATE calls per second on a DT LED node
+ *              (-d) with 1..-n reader threads while one writer flips its
+ *              direction and level
+ *
+ * Options:
+ *   -d <device>  device file (default /dev/teraDriver)
+ *   -s <secs>    duration of every measurement (default 2)
+ *   -n <count>   largest thread count (default online CPUs)
+ *   -b <bytes>   block size of the threads test, largest size of blocksize
+ *   -p <path>    gpio-sim pull file of the input pin, for poll
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <time.h>
+#include <unistd.h>
+#include "../02- Platform Device Driver/tera_gpio_uapi.h"
+#include "../03- Platform Device Driver | dts | Attributes/tera_gpio_uapi.h"
+
+/*
+ * POLL_SAMPLES: Number of edges generated by the poll test.
+ */
+#define POLL_SAMPLES 1000
+
+static const char *device = "/dev/teraDriver";
+static const char *pull_path;
+static double seconds = 2.0;
+static int max_threads;
+static size_t block = 64;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void result(const char *test, long param, const char *metric, double value)
+{
+    printf("%s,%ld,%s,%.0f\n", test, param, metric, value);
+    fflush(stdout);
+}
+
+static int open_device(int flags)
+{
+    int fd = open(device, flags);
+
+    if (fd < 0)
+    {
+        fprintf(stderr, "open %s: %s\n", device, strerror(errno));
+        exit(1);
+    }
+    return fd;
+}
+
+/*
+ * Struct: pair_worker
+ * -------------------
+ * One thread doing write+read pairs until the deadline.
+ */
+struct pair_worker
+{
+    pthread_t thread;
+    size_t size;
+    uint64_t deadline;
+    uint64_t ops;
+    uint64_t bytes;
+    uint64_t busy_ns;
+};
+
+static void *pair_worker_fn(void *data)
+{
+    struct pair_worker *w = data;
+    char *buf = malloc(w->size);
+    int fd = open_device(O_RDWR);
+    uint64_t start = now_ns();
+
+    memset(buf, 'x', w->size);
+    while (now_ns() < w->deadline)
+    {
+        ssize_t ret = write(fd, buf, w->size);
+
+        if (ret > 0)
+        {
+            w->bytes += ret;
+        }
+        ret = read(fd, buf, w->size);
+        if (ret > 0)
+        {
+            w->bytes += ret;
+        }
+        w->ops += 2;
+    }
+    w->busy_ns = now_ns() - start;
+
+    close(fd);
+    free(buf);
+    return NULL;
+}
+
+/*
+ * Function: run_pairs
+ * -------------------
+ * Runs nthreads pair workers and prints their aggregate rates.
+ */
+static double run_pairs(const char *test, long param, int nthreads, size_t size)
+{
+    struct pair_worker *w = calloc(nthreads, sizeof(*w));
+    uint64_t deadline = now_ns() + (uint64_t)(seconds * 1e9);
+    uint64_t ops = 0, bytes = 0, busy = 0;
+    double rate;
+    int i;
+
+    for (i = 0; i < nthreads; i++)
+    {
+        w[i].size = size;
+        w[i].deadline = deadline;
+        pthread_create(&w[i].thread, NULL, pair_worker_fn, &w[i]);
+    }
+    for (i = 0; i < nthreads; i++)
+    {
+        pthread_join(w[i].thread, NULL);
+        ops += w[i].ops;
+        bytes += w[i].bytes;
+        busy += w[i].busy_ns;
+    }
+    free(w);
+
+    rate = ops / seconds;
+    result(test, param, "ops_per_sec", rate);
+    result(test, param, "bytes_per_sec", bytes / seconds);
+    result(test, param, "op_ns", ops ? (double)busy / ops : 0);
+    return rate;
+}
+
+static void bench_blocksize(void)
+{
+    size_t size;
+
+    for (size = 1; size <= block; size *= 2)
+    {
+        run_pairs("blocksize", size, 1, size);
+    }
+}
+
+static void bench_threads(void)
+{
+    double base = 0, rate;
+    int n;
+
+    for (n = 1;; n = n * 2 > max_threads ? max_threads : n * 2)
+    {
+        rate = run_pairs("threads", n, n, block);
+        if (n == 1)
+        {
+            base = rate;
+        }
+        result("threads", n, "scaling_pct", base ? rate * 100 / base : 0);
+        if (n >= max_threads)
+        {
+            break;
+        }
+    }
+}
+
+static void bench_churn(void)
+{
+    uint64_t start = now_ns(), deadline = start + (uint64_t)(seconds * 1e9);
+    uint64_t count = 0;
+
+    while (now_ns() < deadline)
+    {
+        close(open_device(O_RDWR));
+        count++;
+    }
+    result("churn", 0, "opens_per_sec", count / seconds);
+    result("churn", 0, "open_close_ns", (double)(now_ns() - start) / count);
+}
+
+static int compare_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+/*
+ * Function: bench_poll
+ * --------------------
+ * Flips the simulated input through gpio-sim and measures the time from
+ * the pull write to the return of poll(). The pin must already be an
+ * input, see the direction attribute of the 03 driver.
+ */
+static void bench_poll(void)
+{
+    static uint64_t samples[POLL_SAMPLES];
+    char events[256];
+    int fd = open_device(O_RDONLY);
+    int pull, i, n = 0;
+
+    if (pull_path == NULL)
+    {
+        fprintf(stderr, "poll needs the gpio-sim pull file, -p\n");
+        exit(1);
+    }
+    pull = open(pull_path, O_WRONLY);
+    if (pull < 0)
+    {
+        fprintf(stderr, "open %s: %s\n", pull_path, strerror(errno));
+        exit(1);
+    }
+
+    for (i = 0; i < POLL_SAMPLES; i++)
+    {
+        struct pollfd pfd = {.fd = fd, .events = POLLIN};
+        const char *level = i & 1 ? "pull-down" : "pull-up";
+        uint64_t start;
+
+        start = now_ns();
+        if (pwrite(pull, level, strlen(level), 0) < 0)
+        {
+            fprintf(stderr, "write %s: %s\n", pull_path, strerror(errno));
+            exit(1);
+        }
+        if (poll(&pfd, 1, 1000) == 1)
+        {
+            samples[n++] = now_ns() - start;
+            if (read(fd, events, sizeof(events)) < 0) // Drain the queue for the next edge
+            {
+                break;
+            }
+        }
+    }
+    close(pull);
+    close(fd);
+
+    if (n == 0)
+    {
+        fprintf(stderr, "no wakeups, is the pin an input?\n");
+        exit(1);
+    }
+    qsort(samples, n, sizeof(samples[0]), compare_u64);
+    result("poll", n, "wakeup_p50_ns", samples[n / 2]);
+    result("poll", n, "wakeup_p99_ns", samples[n * 99 / 100]);
+    result("poll", n, "wakeup_max_ns", samples[n - 1]);
+}
+
+/*
+ * Function: bench_toggle
+ * ----------------------
+ * Toggle rate of one LED, first with the text protocol ("1010..." writes)
+ * and then with TERA_GPIO_OP_TOGGLE ops of the binary protocol.
+ */
+static void bench_toggle(void)
+{
+    struct tera_gpio_op ops[256];
+    char text[256];
+    uint32_t mode = TERA_GPIO_MODE_BINARY;
+    uint64_t deadline, toggles;
+    int fd = open_device(O_WRONLY);
+    struct stat st;
+    size_t i;
+
+    for (i = 0; i < sizeof(text); i++)
+    {
+        text[i] = i & 1 ? '0' : '1';
+    }
+    toggles = 0;
+    deadline = now_ns() + (uint64_t)(seconds * 1e9);
+    while (now_ns() < deadline)
+    {
+        ssize_t ret = write(fd, text, sizeof(text));
+
+        if (ret < 0)
+        {
+            fprintf(stderr, "write %s: %s\n", device, strerror(errno));
+            exit(1);
+        }
+        toggles += ret;
+    }
+    result("toggle", 0, "text_toggles_per_sec", toggles / seconds);
+
+    if (ioctl(fd, TERA_GPIO_IOC_SET_MODE, &mode) < 0)
+    {
+        fprintf(stderr, "binary protocol not supported: %s\n", strerror(errno));
+        close(fd);
+        return;
+    }
+    /* Bit N of the mask is the LED with minor number N */
+    fstat(fd, &st);
+    memset(ops, 0, sizeof(ops));
+    for (i = 0; i < sizeof(ops) / sizeof(ops[0]); i++)
+    {
+        ops[i].op = TERA_GPIO_OP_TOGGLE;
+        ops[i].mask = 1U << minor(st.st_rdev);
+    }
+    toggles = 0;
+    deadline = now_ns() + (uint64_t)(seconds * 1e9);
+    while (now_ns() < deadline)
+    {
+        ssize_t ret = write(fd, ops, sizeof(ops));
+
+        if (ret < 0)
+        {
+            fprintf(stderr, "write %s: %s\n", device, strerror(errno));
+            exit(1);
+        }
+        toggles += ret / sizeof(ops[0]);
+    }
+    result("toggle", 1, "binary_toggles_per_sec", toggles / seconds);
+    close(fd);
+}
+
+/*
+ * STATE_LEVEL_WRITES: Level writes of the state writer between two switches
+ * to input. Reads of an output never lock, reads of an input do.
+ */
+#define STATE_LEVEL_WRITES 16
+
+/*
+ * Struct: state_worker
+ * --------------------
+ * One thread reading the state of the node, or the writer changing it.
+ */
+struct state_worker
+{
+    pthread_t thread;
+    volatile int *stop;
+    int input_level; /* Level of the pin as an input, the only input pair published */
+    uint64_t ops;
+    uint64_t bad;
+};
+
+static void *state_reader_fn(void *data)
+{
+    struct state_worker *w = data;
+    struct tera_gpio_state state;
+    int fd = open_device(O_RDONLY);
+
+    while (!*w->stop)
+    {
+        /*
+         * The writer publishes (output, 0), (output, 1) and (input,
+         * input_level). Any other pair is torn or garbage.
+         */
+        if (ioctl(fd, TERA_GPIO_IOC_GET_STATE, &state) < 0 || state.level > 1 ||
+            (state.direction != TERA_GPIO_DIR_OUTPUT &&
+             (state.direction != TERA_GPIO_DIR_INPUT || state.level != (__u32)w->input_level)))
+        {
+            w->bad++;
+        }
+        w->ops++;
+    }
+    close(fd);
+    return NULL;
+}
+
+/*
+ * Function: state_set_direction
+ * -----------------------------
+ * Switches the pin of fd, returns 0 on success.
+ */
+static int state_set_direction(int fd, __u32 direction)
+{
+    return ioctl(fd, TERA_GPIO_IOC_SET_DIRECTION, &direction);
+}
+
+static void *state_writer_fn(void *data)
+{
+    struct state_worker *w = data;
+    int fd = open_device(O_RDWR);
+    int i;
+
+    /*
+     * Every cycle publishes (output, input_level) when the pin keeps its
+     * level on the switch, then STATE_LEVEL_WRITES levels starting with
+     * !input_level, and (input, input_level).
+     */
+    while (!*w->stop)
+    {
+        if (state_set_direction(fd, TERA_GPIO_DIR_OUTPUT) < 0)
+        {
+            w->bad++;
+        }
+        for (i = 0; i < STATE_LEVEL_WRITES; i++)
+        {
+            if (write(fd, (i & 1) == w->input_level ? "1" : "0", 1) != 1)
+            {
+                w->bad++;
+            }
+        }
+        if (state_set_direction(fd, TERA_GPIO_DIR_INPUT) < 0)
+        {
+            w->bad++;
+        }
+        w->ops += STATE_LEVEL_WRITES + 2;
+    }
+    state_set_direction(fd, TERA_GPIO_DIR_OUTPUT);
+    close(fd);
+    return NULL;
+}
+
+/*
+ * Function: state_input_level
+ * ---------------------------
+ * Switches the node to input and returns the level its pull gives it.
+ */
+static int state_input_level(void)
+{
+    struct tera_gpio_state state;
+    int fd = open_device(O_RDWR);
+
+    if (state_set_direction(fd, TERA_GPIO_DIR_INPUT) < 0 || ioctl(fd, TERA_GPIO_IOC_GET_STATE, &state) < 0)
+    {
+        fprintf(stderr, "state %s: %s\n", device, strerror(errno));
+        exit(1);
+    }
+    state_set_direction(fd, TERA_GPIO_DIR_OUTPUT);
+    close(fd);
+    return state.level;
+}
+
+/*
+ * Function: bench_state
+ * ---------------------
+ * Reads the (direction, level) pair of a DT LED node with
+ * TERA_GPIO_IOC_GET_STATE from 1, 2, 4, ... threads while one writer keeps
+ * switching the pin between output 0, output 1 and input. The pair is read
+ * under a seqlock, so the read rate should scale with the readers, the
+ * writer rate should not drop as readers are added, and no reader should
+ * ever see a pair the writer did not publish.
+ */
+static void bench_state(void)
+{
+    struct state_worker *w;
+    double base = 0, rate;
+    int input_level = state_input_level();
+    int n, i;
+
+    w = calloc(max_threads + 1, sizeof(*w));
+    for (n = 1;; n = n * 2 > max_threads ? max_threads : n * 2)
+    {
+        volatile int stop = 0;
+        uint64_t reads = 0, bad = 0;
+
+        memset(w, 0, (n + 1) * sizeof(*w));
+        for (i = 0; i <= n; i++)
+        {
+            w[i].stop = &stop;
+            w[i].input_level = input_level;
+            pthread_create(&w[i].thread, NULL, i == n ? state_writer_fn : state_reader_fn, &w[i]);
+        }
+        usleep(seconds * 1e6);
+        stop = 1;
+        for (i = 0; i <= n; i++)
+        {
+            pthread_join(w[i].thread, NULL);
+        }
+        for (i = 0; i < n; i++)
+        {
+            reads += w[i].ops;
+            bad += w[i].bad;
+        }
+
+        rate = reads / seconds;
+        if (n == 1)
+        {
+            base = rate;
+        }
+        result("state", n, "reads_per_sec", rate);
+        result("state", n, "scaling_pct", base ? rate * 100 / base : 0);
+        result("state", n, "writes_per_sec", w[n].ops / seconds);
+        if (bad || w[n].bad)
+        {
+            fprintf(stderr, "state: %llu bad pairs, %llu failed write cycles with %d readers\n",
+                    (unsigned long long)bad, (unsigned long long)w[n].bad, n);
+        }
+        if (n >= max_threads)
+        {
+            break;
+        }
+    }
+    free(w);
+}
+
+int main(int argc, char **argv)
+{
+    const char *test;
+    int opt;
+
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s blocksize|threads|churn|poll|toggle|state [-d dev] [-s secs] [-n threads] [-b bytes] [-p pull]\n", argv[0]);
+        return 1;
+    }
+    test = argv[1];
+    optind = 2;
+
+    max_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    while ((opt = getopt(argc, argv, "d:s:n:b:p:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'd':
+            device = optarg;
+            break;
+        case 's':
+            seconds = atof(optarg);
+            break;
+        case 'n':
+            max_threads = atoi(optarg);
+            break;
+        case 'b':
+            block = strtoul(optarg, NULL, 0);
+            break;
+        case 'p':
+            pull_path = optarg;
+            break;
+        default:
+            return 1;
+        }
+    }
+    if (seconds <= 0 || max_threads < 1 || block < 1)
+    {
+        fprintf(stderr, "invalid option\n");
+        return 1;
+    }
+
+    if (strcmp(test, "blocksize") == 0)
+    {
+        bench_blocksize();
+    }
+    else if (strcmp(test, "threads") == 0)
+    {
+        bench_threads();
+    }
+    else if (strcmp(test, "churn") == 0)
+    {
+        bench_churn();
+    }
+    else if (strcmp(test, "poll") == 0)
+    {
+        bench_poll();
+    }
+    else if (strcmp(test, "toggle") == 0)
+    {
+        bench_toggle();
+    }
+    else if (strcmp(test, "state") == 0)
+    {
+        bench_state();
+    }
+    else
+    {
+        fprintf(stderr, "unknown test %s\n", test);
+        return 1;
+    }
+    return 0;
+}
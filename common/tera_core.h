@@ -0,0 +1,18 @@
+/*
+ * Author: Eng. Mostafa Tera
+ * Date: 19/10/2026
+ */
+
+#ifndef TERA_CORE
+#define TERA_CORE
+
+#include <linux/debugfs.h>
+
+/*
+ * Function: tera_core_debugfs_root
+ * --------------------------------
+ * The /sys/kernel/debug/tera/ directory shared by the tera drivers.
+ */
+struct dentry *tera_core_debugfs_root(void);
+
+#endif // !TERA_CORE
@@ -0,0 +1,51 @@
+/*
+ * Author: Eng. Mostafa Tera
+ * Date: 19/10/2026
+ */
+
+#include <linux/init.h>
+#include <linux/module.h>
+#include "tera_core.h"
+#include "tera_pmu.h"
+
+MODULE_LICENSE("GPL");
+MODULE_AUTHOR("MOSTAFA TERA");
+MODULE_DESCRIPTION("Helpers shared by the tera drivers");
+
+/*
+ * Variable: tera_debugfs_root
+ * ---------------------------
+ * /sys/kernel/debug/tera/, every driver module creates its directory below.
+ */
+static struct dentry *tera_debugfs_root;
+
+struct dentry *tera_core_debugfs_root(void)
+{
+    return tera_debugfs_root;
+}
+EXPORT_SYMBOL_GPL(tera_core_debugfs_root);
+
+static int __init tera_core_init(void)
+{
+    int ret;
+
+    tera_debugfs_root = debugfs_create_dir("tera", NULL);
+
+    // perf stat -a -e tera/bytes_written/
+    ret = tera_pmu_init();
+    if (ret)
+    {
+        printk("tera PMU can not be registered!\n");
+        debugfs_remove(tera_debugfs_root);
+    }
+    return ret;
+}
+
+static void __exit tera_core_exit(void)
+{
+    tera_pmu_exit();
+    debugfs_remove(tera_debugfs_root);
+}
+
+module_init(tera_core_init);
+module_exit(tera_core_exit);
@@ -0,0 +1,176 @@
+/*
+ * Author: Eng. Mostafa Tera
+ * Date: 19/10/2026
+ */
+
+#include <linux/module.h>
+#include <linux/perf_event.h>
+#include <linux/cpumask.h>
+#include "tera_pmu.h"
+
+DEFINE_PER_CPU(u64, tera_pmu_counts[TERA_PMU_MAX]);
+EXPORT_PER_CPU_SYMBOL_GPL(tera_pmu_counts);
+
+/*
+ * The counters are global to the drivers, not per task or per CPU, so the
+ * PMU works like an uncore PMU: counting only, system wide, and opened on
+ * the single CPU advertised in cpumask so perf does not sum copies.
+ */
+#define TERA_PMU_CPU 0
+
+/*
+ * Function: tera_pmu_sum
+ * ----------------------
+ * Total of one event over every CPU.
+ */
+static u64 tera_pmu_sum(u64 config)
+{
+    u64 sum = 0;
+    int cpu;
+
+    for_each_possible_cpu(cpu)
+    {
+        sum += READ_ONCE(per_cpu(tera_pmu_counts, cpu)[config]);
+    }
+    return sum;
+}
+
+static void tera_pmu_event_update(struct perf_event *event)
+{
+    struct hw_perf_event *hwc = &event->hw;
+    u64 prev, now;
+
+    do
+    {
+        prev = local64_read(&hwc->prev_count);
+        now = tera_pmu_sum(event->attr.config);
+    } while (local64_cmpxchg(&hwc->prev_count, prev, now) != prev);
+
+    local64_add(now - prev, &event->count);
+}
+
+static int tera_pmu_event_init(struct perf_event *event)
+{
+    if (event->attr.type != event->pmu->type)
+    {
+        return -ENOENT;
+    }
+    if (event->attr.config >= TERA_PMU_MAX)
+    {
+        return -EINVAL;
+    }
+    /* Counting only, and not attributable to a task */
+    if (is_sampling_event(event) || event->attach_state & PERF_ATTACH_TASK || event->cpu < 0)
+    {
+        return -EINVAL;
+    }
+
+    event->cpu = TERA_PMU_CPU;
+    return 0;
+}
+
+static void tera_pmu_event_start(struct perf_event *event, int flags)
+{
+    local64_set(&event->hw.prev_count, tera_pmu_sum(event->attr.config));
+    event->hw.state = 0;
+}
+
+static void tera_pmu_event_stop(struct perf_event *event, int flags)
+{
+    if (event->hw.state & PERF_HES_STOPPED)
+    {
+        return;
+    }
+    tera_pmu_event_update(event);
+    event->hw.state |= PERF_HES_STOPPED | PERF_HES_UPTODATE;
+}
+
+static int tera_pmu_event_add(struct perf_event *event, int flags)
+{
+    event->hw.state = PERF_HES_STOPPED | PERF_HES_UPTODATE;
+    if (flags & PERF_EF_START)
+    {
+        tera_pmu_event_start(event, flags);
+    }
+    return 0;
+}
+
+static void tera_pmu_event_del(struct perf_event *event, int flags)
+{
+    tera_pmu_event_stop(event, PERF_EF_UPDATE);
+}
+
+static ssize_t cpumask_show(struct device *dev, struct device_attribute *attr, char *buf)
+{
+    return cpumap_print_to_pagebuf(true, buf, cpumask_of(TERA_PMU_CPU));
+}
+static DEVICE_ATTR_RO(cpumask);
+
+static struct attribute *tera_pmu_cpumask_attrs[] = {
+    &dev_attr_cpumask.attr,
+    NULL,
+};
+
+static const struct attribute_group tera_pmu_cpumask_group = {
+    .attrs = tera_pmu_cpumask_attrs,
+};
+
+PMU_FORMAT_ATTR(event, "config:0-7");
+
+static struct attribute *tera_pmu_format_attrs[] = {
+    &format_attr_event.attr,
+    NULL,
+};
+
+static const struct attribute_group tera_pmu_format_group = {
+    .name = "format",
+    .attrs = tera_pmu_format_attrs,
+};
+
+PMU_EVENT_ATTR_STRING(bytes_written, tera_pmu_bytes_written, "event=0x00");
+PMU_EVENT_ATTR_STRING(gpio_toggles, tera_pmu_gpio_toggles, "event=0x01");
+PMU_EVENT_ATTR_STRING(read_wakeups, tera_pmu_read_wakeups, "event=0x02");
+PMU_EVENT_ATTR_STRING(buffer_full, tera_pmu_buffer_full, "event=0x03");
+
+static struct attribute *tera_pmu_event_attrs[] = {
+    &tera_pmu_bytes_written.attr.attr,
+    &tera_pmu_gpio_toggles.attr.attr,
+    &tera_pmu_read_wakeups.attr.attr,
+    &tera_pmu_buffer_full.attr.attr,
+    NULL,
+};
+
+static const struct attribute_group tera_pmu_events_group = {
+    .name = "events",
+    .attrs = tera_pmu_event_attrs,
+};
+
+static const struct attribute_group *tera_pmu_attr_groups[] = {
+    &tera_pmu_cpumask_group,
+    &tera_pmu_format_group,
+    &tera_pmu_events_group,
+    NULL,
+};
+
+static struct pmu tera_pmu = {
+    .module = THIS_MODULE,
+    .task_ctx_nr = perf_invalid_context,
+    .capabilities = PERF_PMU_CAP_NO_EXCLUDE,
+    .attr_groups = tera_pmu_attr_groups,
+    .event_init = tera_pmu_event_init,
+    .add = tera_pmu_event_add,
+    .del = tera_pmu_event_del,
+    .start = tera_pmu_event_start,
+    .stop = tera_pmu_event_stop,
+    .read = tera_pmu_event_update,
+};
+
+int tera_pmu_init(void)
+{
+    return perf_pmu_register(&tera_pmu, "tera", -1);
+}
+
+void tera_pmu_exit(void)
+{
+    perf_pmu_unregister(&tera_pmu);
+}
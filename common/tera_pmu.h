@@ -0,0 +1,52 @@
+/*
+ * Author: Eng. Mostafa Tera
+ * Date: 19/10/2026
+ */
+
+#ifndef TERA_PMU
+#define TERA_PMU
+
+#include <linux/percpu.h>
+
+/*
+ * Enum: tera_pmu_event
+ * --------------------
+ * Events of the "tera" perf PMU, config value of tera/<name>/.
+ */
+enum tera_pmu_event
+{
+    TERA_PMU_BYTES_WRITTEN, /* Bytes accepted by driver_write */
+    TERA_PMU_GPIO_TOGGLES,  /* GPIO level updates */
+    TERA_PMU_READ_WAKEUPS,  /* Readers woken because data arrived */
+    TERA_PMU_BUFFER_FULL,   /* Writes or events refused because a buffer was full */
+    TERA_PMU_MAX
+};
+
+DECLARE_PER_CPU(u64, tera_pmu_counts[TERA_PMU_MAX]);
+
+/*
+ * Function: tera_pmu_add
+ * ----------------------
+ * Counts value occurrences of an event. A per-CPU add, cheap enough for
+ * every call of the hot paths whether perf is running or not.
+ */
+static inline void tera_pmu_add(enum tera_pmu_event event, u64 value)
+{
+    this_cpu_add(tera_pmu_counts[event], value);
+}
+
+/*
+ * Function: tera_pmu_init
+ * -----------------------
+ * Registers the PMU with perf.
+ */
+int tera_pmu_init(void);
+
+/*
+ * Function: tera_pmu_exit
+ * -----------------------
+ * Unregisters the PMU.
+ */
+void tera_pmu_exit(void);
+
+#endif // !TERA_PMU
@@ -0,0 +1,156 @@
+/*
+ * Author: Eng. Mostafa Tera
+ * Date: 19/10/2026
+ */
+
+#include <linux/module.h>
+#include <linux/seq_file.h>
+#include "tera_stats.h"
+#include "tera_core.h"
+
+static const char *const tera_path_names[TERA_PATH_MAX] = {
+    [TERA_PATH_READ] = "read",
+    [TERA_PATH_WRITE] = "write",
+    [TERA_PATH_GPIO_SET] = "gpio_set",
+};
+
+int tera_stats_init(struct tera_stats *stats)
+{
+    stats->cpu = alloc_percpu(struct tera_stats_cpu);
+    stats->dir = NULL;
+    return stats->cpu ? 0 : -ENOMEM;
+}
+EXPORT_SYMBOL_GPL(tera_stats_init);
+
+void tera_stats_exit(struct tera_stats *stats)
+{
+    free_percpu(stats->cpu);
+    stats->cpu = NULL;
+}
+EXPORT_SYMBOL_GPL(tera_stats_exit);
+
+/*
+ * Function: tera_stats_counters_show
+ * ----------------------------------
+ * Sums the counters of every CPU, one line per path.
+ */
+static int tera_stats_counters_show(struct seq_file *s, void *unused)
+{
+    struct tera_stats *stats = s->private;
+    u64 sum[TERA_STAT_MAX];
+    int path, stat, cpu;
+
+    seq_printf(s, "%-10s %16s %16s %12s %12s %12s\n", "path", "ops", "bytes", "errors", "short", "drops");
+
+    for (path = 0; path < TERA_PATH_MAX; path++)
+    {
+        memset(sum, 0, sizeof(sum));
+        for_each_possible_cpu(cpu)
+        {
+            struct tera_stats_cpu *c = per_cpu_ptr(stats->cpu, cpu);
+
+            for (stat = 0; stat < TERA_STAT_MAX; stat++)
+            {
+                sum[stat] += READ_ONCE(c->count[path][stat]);
+            }
+        }
+        seq_printf(s, "%-10s %16llu %16llu %12llu %12llu %12llu\n", tera_path_names[path],
+                   sum[TERA_STAT_OPS], sum[TERA_STAT_BYTES], sum[TERA_STAT_ERRORS],
+                   sum[TERA_STAT_SHORT], sum[TERA_STAT_DROPS]);
+    }
+    return 0;
+}
+
+static int tera_stats_counters_open(struct inode *inode, struct file *file)
+{
+    return single_open(file, tera_stats_counters_show, inode->i_private);
+}
+
+/*
+ * Function: tera_stats_counters_write
+ * -----------------------------------
+ * Any write clears the counters and histograms of the device. Updates
+ * racing with the clear may survive it.
+ */
+static ssize_t tera_stats_counters_write(struct file *file, const char __user *buf, size_t count, loff_t *ppos)
+{
+    struct tera_stats *stats = ((struct seq_file *)file->private_data)->private;
+    int cpu;
+
+    for_each_possible_cpu(cpu)
+    {
+        memset(per_cpu_ptr(stats->cpu, cpu), 0, sizeof(struct tera_stats_cpu));
+    }
+    return count;
+}
+
+static const struct file_operations tera_stats_counters_fops = {
+    .owner = THIS_MODULE,
+    .open = tera_stats_counters_open,
+    .read = seq_read,
+    .write = tera_stats_counters_write,
+    .llseek = seq_lseek,
+    .release = single_release,
+};
+
+/*
+ * Function: tera_stats_hist_show
+ * ------------------------------
+ * Prints the non-empty buckets of a histogram as "low_ns high_ns count".
+ */
+static int tera_stats_hist_show(struct seq_file *s, void *unused)
+{
+    struct tera_stats_hist *hist = s->private;
+    int bucket, cpu;
+
+    for (bucket = 0; bucket < TERA_STATS_BUCKETS; bucket++)
+    {
+        u64 sum = 0;
+
+        for_each_possible_cpu(cpu)
+        {
+            sum += READ_ONCE(per_cpu_ptr(hist->stats->cpu, cpu)->hist[hist->path][bucket]);
+        }
+        if (sum)
+        {
+            seq_printf(s, "%llu %llu %llu\n", bucket ? 1ULL << bucket : 0, 1ULL << (bucket + 1), sum);
+        }
+    }
+    return 0;
+}
+
+DEFINE_SHOW_ATTRIBUTE(tera_stats_hist);
+
+struct dentry *tera_stats_module_dir(const char *name)
+{
+    return debugfs_create_dir(name, tera_core_debugfs_root());
+}
+EXPORT_SYMBOL_GPL(tera_stats_module_dir);
+
+void tera_stats_debugfs(struct tera_stats *stats, struct dentry *parent, const char *name)
+{
+    static const char *const files[TERA_PATH_MAX] = {
+        [TERA_PATH_READ] = "read_latency",
+        [TERA_PATH_WRITE] = "write_latency",
+        [TERA_PATH_GPIO_SET] = "gpio_set_latency",
+    };
+    int path;
+
+    stats->dir = debugfs_create_dir(name, parent);
+    debugfs_create_file("stats", 0600, stats->dir, stats, &tera_stats_counters_fops);
+
+    for (path = 0; path < TERA_PATH_MAX; path++)
+    {
+        stats->hist[path].stats = stats;
+        stats->hist[path].path = path;
+        debugfs_create_file(files[path], 0400, stats->dir, &stats->hist[path], &tera_stats_hist_fops);
+    }
+}
+EXPORT_SYMBOL_GPL(tera_stats_debugfs);
+
+void tera_stats_debugfs_remove(struct tera_stats *stats)
+{
+    debugfs_remove(stats->dir);
+    stats->dir = NULL;
+}
+EXPORT_SYMBOL_GPL(tera_stats_debugfs_remove);
@@ -0,0 +1,177 @@
+/*
+ * Author: Eng. Mostafa Tera
+ * Date: 19/10/2026
+ */
+
+#ifndef TERA_STATS
+#define TERA_STATS
+
+#include <linux/percpu.h>
+#include <linux/log2.h>
+#include <linux/sched/clock.h>
+#include <linux/debugfs.h>
+
+/*
+ * Enum: tera_stat_path
+ * --------------------
+ * Measured operations of a device.
+ */
+enum tera_stat_path
+{
+    TERA_PATH_READ,     /* driver_read */
+    TERA_PATH_WRITE,    /* driver_write */
+    TERA_PATH_GPIO_SET, /* One GPIO set operation */
+    TERA_PATH_MAX
+};
+
+/*
+ * Enum: tera_stat
+ * ---------------
+ * Counters kept for every path.
+ */
+enum tera_stat
+{
+    TERA_STAT_OPS,    /* Calls */
+    TERA_STAT_BYTES,  /* Bytes transferred */
+    TERA_STAT_ERRORS, /* Calls that returned an error */
+    TERA_STAT_SHORT,  /* Calls that transferred less than requested */
+    TERA_STAT_DROPS,  /* Data the device had to throw away */
+    TERA_STAT_MAX
+};
+
+/*
+ * TERA_STATS_BUCKETS: Latency histogram size, bucket N counts the
+ * calls that took [2^N, 2^(N+1)) ns.
+ */
+#define TERA_STATS_BUCKETS 32
+
+/*
+ * Struct: tera_stats_cpu
+ * ----------------------
+ * Counters of one CPU. Only that CPU writes them, so updates need no
+ * lock and no atomic instruction.
+ */
+struct tera_stats_cpu
+{
+    u64 count[TERA_PATH_MAX][TERA_STAT_MAX];
+    u64 hist[TERA_PATH_MAX][TERA_STATS_BUCKETS];
+};
+
+struct tera_stats;
+
+/*
+ * Struct: tera_stats_hist
+ * -----------------------
+ * Private data of one histogram file in debugfs.
+ */
+struct tera_stats_hist
+{
+    struct tera_stats *stats;
+    enum tera_stat_path path;
+};
+
+/*
+ * Struct: tera_stats
+ * ------------------
+ * Statistics of one device, shown in debugfs as
+ * /sys/kernel/debug/tera/<module>/<device>/.
+ */
+struct tera_stats
+{
+    struct tera_stats_cpu __percpu *cpu;
+    struct dentry *dir;
+    struct tera_stats_hist hist[TERA_PATH_MAX];
+};
+
+/*
+ * Function: tera_stats_init
+ * -------------------------
+ * Allocates the per-CPU counters.
+ *
+ * Returns:
+ * - 0 on success, otherwise -ENOMEM.
+ */
+int tera_stats_init(struct tera_stats *stats);
+
+/*
+ * Function: tera_stats_exit
+ * -------------------------
+ * Frees the per-CPU counters. The debugfs directory must be removed first.
+ */
+void tera_stats_exit(struct tera_stats *stats);
+
+/*
+ * Function: tera_stats_module_dir
+ * -------------------------------
+ * Creates /sys/kernel/debug/tera/<name>/ for a driver module. Remove it
+ * with debugfs_remove() on module exit.
+ */
+struct dentry *tera_stats_module_dir(const char *name);
+
+/*
+ * Function: tera_stats_debugfs
+ * ----------------------------
+ * Creates the debugfs directory of a device below parent:
+ * - stats: counters of every path, any write clears them.
+ * - read_latency, write_latency, gpio_set_latency: log2 histograms.
+ */
+void tera_stats_debugfs(struct tera_stats *stats, struct dentry *parent, const char *name);
+
+/*
+ * Function: tera_stats_debugfs_remove
+ * -----------------------------------
+ * Removes the debugfs directory of a device.
+ */
+void tera_stats_debugfs_remove(struct tera_stats *stats);
+
+/*
+ * Function: tera_stats_start
+ * --------------------------
+ * Timestamp taken at the start of a measured operation.
+ */
+static inline u64 tera_stats_start(void)
+{
+    return local_clock();
+}
+
+/*
+ * Function: tera_stats_add
+ * ------------------------
+ * Adds value to one counter of a path.
+ */
+static inline void tera_stats_add(struct tera_stats *stats, enum tera_stat_path path, enum tera_stat stat, u64 value)
+{
+    this_cpu_add(stats->cpu->count[path][stat], value);
+}
+
+/*
+ * Function: tera_stats_op
+ * -----------------------
+ * Records one finished operation: ret is its return value, requested the
+ * number of bytes asked for and start the value of tera_stats_start().
+ *
+ * Returns:
+ * - The latency of the operation in ns, for the matching tracepoint.
+ */
+static inline u64 tera_stats_op(struct tera_stats *stats, enum tera_stat_path path, ssize_t ret, size_t requested, u64 start)
+{
+    u64 ns = local_clock() - start;
+
+    this_cpu_inc(stats->cpu->count[path][TERA_STAT_OPS]);
+    if (ret < 0)
+    {
+        this_cpu_inc(stats->cpu->count[path][TERA_STAT_ERRORS]);
+    }
+    else
+    {
+        this_cpu_add(stats->cpu->count[path][TERA_STAT_BYTES], ret);
+        if ((size_t)ret < requested)
+        {
+            this_cpu_inc(stats->cpu->count[path][TERA_STAT_SHORT]);
+        }
+    }
+    this_cpu_inc(stats->cpu->hist[path][min_t(u64, ilog2(ns | 1), TERA_STATS_BUCKETS - 1)]);
+    return ns;
+}
+
+#endif // !TERA_STATS
@@ -0,0 +1,16 @@
+/*
+ * Author: Eng. Mostafa Tera
+ * Date: 19/10/2026
+ */
+
+#include <linux/module.h>
+
+#define CREATE_TRACE_POINTS
+#include "tera_trace.h"
+
+EXPORT_TRACEPOINT_SYMBOL_GPL(tera_open);
+EXPORT_TRACEPOINT_SYMBOL_GPL(tera_close);
+EXPORT_TRACEPOINT_SYMBOL_GPL(tera_read);
+EXPORT_TRACEPOINT_SYMBOL_GPL(tera_write);
+EXPORT_TRACEPOINT_SYMBOL_GPL(tera_gpio_set);
+EXPORT_TRACEPOINT_SYMBOL_GPL(tera_probe);
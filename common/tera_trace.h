@@ -0,0 +1,148 @@
+/*
+ * Author: Eng. Mostafa Tera
+ * Date: 19/10/2026
+ */
+
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM tera
+
+#if !defined(TERA_TRACE) || defined(TRACE_HEADER_MULTI_READ)
+#define TERA_TRACE
+
+#include <linux/tracepoint.h>
+#include <linux/kdev_t.h>
+
+/*
+ * Tracepoints of the tera drivers, defined once in tera_core and exported
+ * to the driver modules. Every call site is a static branch that stays a
+ * no-op until the event is enabled through ftrace, perf or BPF:
+ *
+ *   perf record -e 'tera:*' ...
+ *   echo 1 > /sys/kernel/tracing/events/tera/enable
+ */
+
+DECLARE_EVENT_CLASS(tera_file,
+
+    TP_PROTO(dev_t devt),
+
+    TP_ARGS(devt),
+
+    TP_STRUCT__entry(
+        __field(dev_t, devt)
+    ),
+
+    TP_fast_assign(
+        __entry->devt = devt;
+    ),
+
+    TP_printk("major=%d minor=%d", MAJOR(__entry->devt), MINOR(__entry->devt))
+);
+
+/* A device file was opened */
+DEFINE_EVENT(tera_file, tera_open,
+    TP_PROTO(dev_t devt),
+    TP_ARGS(devt)
+);
+
+/* A device file was closed */
+DEFINE_EVENT(tera_file, tera_close,
+    TP_PROTO(dev_t devt),
+    TP_ARGS(devt)
+);
+
+DECLARE_EVENT_CLASS(tera_io,
+
+    TP_PROTO(dev_t devt, size_t count, ssize_t ret, u64 latency_ns),
+
+    TP_ARGS(devt, count, ret, latency_ns),
+
+    TP_STRUCT__entry(
+        __field(dev_t, devt)
+        __field(size_t, count)
+        __field(ssize_t, ret)
+        __field(u64, latency_ns)
+    ),
+
+    TP_fast_assign(
+        __entry->devt = devt;
+        __entry->count = count;
+        __entry->ret = ret;
+        __entry->latency_ns = latency_ns;
+    ),
+
+    TP_printk("major=%d minor=%d count=%zu ret=%zd latency_ns=%llu",
+              MAJOR(__entry->devt), MINOR(__entry->devt),
+              __entry->count, __entry->ret, __entry->latency_ns)
+);
+
+/* driver_read finished, ret is its return value */
+DEFINE_EVENT(tera_io, tera_read,
+    TP_PROTO(dev_t devt, size_t count, ssize_t ret, u64 latency_ns),
+    TP_ARGS(devt, count, ret, latency_ns)
+);
+
+/* driver_write finished, ret is its return value */
+DEFINE_EVENT(tera_io, tera_write,
+    TP_PROTO(dev_t devt, size_t count, ssize_t ret, u64 latency_ns),
+    TP_ARGS(devt, count, ret, latency_ns)
+);
+
+/* A GPIO pin was driven, or handed to the worker that drives it */
+TRACE_EVENT(tera_gpio_set,
+
+    TP_PROTO(int minor, int gpio, int value, u64 latency_ns),
+
+    TP_ARGS(minor, gpio, value, latency_ns),
+
+    TP_STRUCT__entry(
+        __field(int, minor)
+        __field(int, gpio)
+        __field(int, value)
+        __field(u64, latency_ns)
+    ),
+
+    TP_fast_assign(
+        __entry->minor = minor;
+        __entry->gpio = gpio;
+        __entry->value = value;
+        __entry->latency_ns = latency_ns;
+    ),
+
+    TP_printk("minor=%d gpio=%d value=%d latency_ns=%llu",
+              __entry->minor, __entry->gpio, __entry->value, __entry->latency_ns)
+);
+
+/* A platform device probe finished, ret is its return value */
+TRACE_EVENT(tera_probe,
+
+    TP_PROTO(const char *name, int minor, int ret, u64 latency_ns),
+
+    TP_ARGS(name, minor, ret, latency_ns),
+
+    TP_STRUCT__entry(
+        __array(char, name, 32)
+        __field(int, minor)
+        __field(int, ret)
+        __field(u64, latency_ns)
+    ),
+
+    TP_fast_assign(
+        strscpy(__entry->name, name, sizeof(__entry->name));
+        __entry->minor = minor;
+        __entry->ret = ret;
+        __entry->latency_ns = latency_ns;
+    ),
+
+    TP_printk("name=%s minor=%d ret=%d latency_ns=%llu",
+              __entry->name, __entry->minor, __entry->ret, __entry->latency_ns)
+);
+
+#endif // !TERA_TRACE
+
+/* The trace header lives next to the module, not in include/trace/events */
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE tera_trace
+
+#include <trace/define_trace.h>